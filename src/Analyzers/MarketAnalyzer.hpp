@@ -1,14 +1,16 @@
 #include <cmath>
 #include <vector>
 #include <numeric>
-#include <algorithm> //  std::max  std::min
+#include <algorithm> // для std::max и std::min
+#include "../Cache/CandleCache.hpp"
+#include "../Indicators/SimdKernels.hpp"
 
 struct MarketState {
-    std::string trend;  // "", "", ""
+    std::string trend;  // "Рост", "Падение", "Флэт"
     bool is_trend;
-    double volatility;  //  ( )
-    double normalized_volatility;  //   [0, 1]
-    double volatility_percent;  //   
+    double volatility;  // Волатильность (стандартное отклонение)
+    double normalized_volatility;  // Нормализованная волатильность [0, 1]
+    double volatility_percent;  // Волатильность в процентах
     double max_price;
     double min_price;
 };
@@ -18,44 +20,35 @@ public:
     MarketAnalyzer(std::shared_ptr<Informer> informer) : informer(informer) {}
 
     MarketState analyze_market(const std::string& symbol, const std::string& start_date, const std::string& end_date) {
-        std::vector<CandleData> candles = informer->get_symbol_historical(symbol, start_date, end_date, "60");
+        CandleSeries candles = CandleCache::getInstance().get_symbol_historical(informer, symbol, start_date, end_date, "60");
+        Span<const double> closes = candles.close();
         MarketState state;
 
         if (candles.size() < 5) {
-            return state;  //    
+            return state;  // Недостаточно данных для анализа
         }
 
-        std::vector<double> close_prices;
-        double max_price = candles[0].close, min_price = candles[0].close;
-        double price_change_sum = 0;
+        // Все агрегаты по ценам закрытия со второй свечи - за один векторный проход
+        Span<const double> close_prices = closes.subspan(1);
+        SimdKernels::SeriesStats stats = SimdKernels::stats(close_prices);
+        double max_price = std::max(closes[0], stats.max);
+        double min_price = std::min(closes[0], stats.min);
+        // Сумма изменений цены между соседними свечами
+        double price_change_sum = closes.back() - closes.front();
 
-        //       / 
-        for (size_t i = 1; i < candles.size(); ++i) {
-            double close = candles[i].close;
-            close_prices.push_back(close);
-            max_price = std::max(max_price, close);
-            min_price = std::min(min_price, close);
+        // Вычисляем волатильность (стандартное отклонение)
+        double volatility = std::sqrt(stats.variance);
 
-            double change = close - candles[i - 1].close;
-            price_change_sum += change;
-        }
-
-        //   ( )
-        double mean = std::accumulate(close_prices.begin(), close_prices.end(), 0.0) / close_prices.size();
-        double variance = 0;
-        for (double price : close_prices) variance += (price - mean) * (price - mean);
-        double volatility = std::sqrt(variance / close_prices.size());
-
-        //     [0, 1]
+        // Нормализация волатильности в диапазоне [0, 1]
         double price_range = max_price - min_price;
         double normalized_volatility = (price_range == 0) ? 0 : (volatility / price_range);
 
-        //   
+        // Перевод в проценты
         double volatility_percent = normalized_volatility * 100;
 
-        //    (SMA)  
+        // Анализ скользящей средней (SMA) для тренда
         double sma_short = std::accumulate(close_prices.end() - 3, close_prices.end(), 0.0) / 3;
-        double sma_long = std::accumulate(close_prices.begin(), close_prices.end(), 0.0) / close_prices.size();
+        double sma_long = stats.mean;
 
         if (price_change_sum > 0 && sma_short > sma_long) {
             state.trend = "Up";
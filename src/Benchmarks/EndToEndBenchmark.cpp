@@ -0,0 +1,356 @@
+﻿// Сквозной бенчмарк без сети и MySQL: боты, бэктесты и HTTP-запросы идут через BotHandler
+// на данных ReplayInformer, сделки пишутся в MemoryBroker.
+//
+//   TradeBotBenchmark [--bots 100] [--ticks 200] [--backtests 20] [--requests 50] [--clients 4]
+//                     [--candles 5000] [--strategy 1] [--symbol BTCUSDT] [--interval 1]
+//                     [--replay-dir DIR] [--param name=value ...]
+//
+// Без --replay-dir используется синтетический ряд (случайное блуждание с фиксированным зерном),
+// поэтому два прогона на одной сборке обрабатывают одни и те же данные.
+
+#include "../BotHandler.hpp"
+#include "../TradeBots/TradeBot.hpp"
+#include "../Informers/ReplayInformer.hpp"
+#include "../Brokers/MemoryBroker.hpp"
+#include "./SyntheticCandles.hpp"
+#include "../Server/HttpServer.hpp"
+#include "../Server/RequestJson.hpp"
+#include "../Utils/LatencyHistogram.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "../Utils/Logger.hpp"
+#include <boost/asio/connect.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+    struct Options {
+        size_t bots = 100;
+        size_t ticks = 200;
+        size_t backtests = 20;
+        size_t requests = 50;
+        size_t clients = 4;
+        size_t candles = 5000;
+        int strategy = 1;
+        std::string symbol = "BTCUSDT";
+        std::string interval = "1";
+        std::string replay_dir;
+        std::map<std::string, std::string> params;
+    };
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string name = argv[i];
+            std::string value = argv[i + 1];
+            if (name == "--bots") options.bots = std::stoul(value);
+            else if (name == "--ticks") options.ticks = std::stoul(value);
+            else if (name == "--backtests") options.backtests = std::stoul(value);
+            else if (name == "--requests") options.requests = std::stoul(value);
+            else if (name == "--clients") options.clients = std::max<size_t>(1, std::stoul(value));
+            else if (name == "--candles") options.candles = std::max<size_t>(1, std::stoul(value));
+            else if (name == "--strategy") options.strategy = std::stoi(value);
+            else if (name == "--symbol") options.symbol = value;
+            else if (name == "--interval") options.interval = value;
+            else if (name == "--replay-dir") options.replay_dir = value;
+            else if (name == "--param" && value.find('=') != std::string::npos) {
+                options.params[value.substr(0, value.find('='))] = value.substr(value.find('=') + 1);
+            }
+            else throw std::invalid_argument("Unknown option " + name);
+        }
+        return options;
+    }
+
+    void set_env(const char* name, const char* value) {
+#ifdef _WIN32
+        _putenv_s(name, value);
+#else
+        setenv(name, value, 1);
+#endif
+    }
+
+    // Оставляет в журнале только предупреждения и ошибки на время фазы: BotHandler и бэктесты пишут строку на каждого бота
+    class QuietLog {
+    public:
+        QuietLog() : previous_(Logger::getInstance().level()) {
+            Logger::getInstance().set_level(std::max(previous_, LogLevel::Warn));
+        }
+        ~QuietLog() { Logger::getInstance().set_level(previous_); }
+    private:
+        LogLevel previous_;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point now() { return Clock::now(); }
+
+    std::chrono::microseconds since(Clock::time_point started) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(now() - started);
+    }
+
+    void report(const std::string& phase, const LatencyHistogram& histogram, std::chrono::microseconds elapsed) {
+        LatencySnapshot snapshot = histogram.snapshot();
+        double seconds = elapsed.count() / 1e6;
+        std::printf("%-10s %8llu ops %10.1f ops/s   p50 %8llu us   p90 %8llu us   p99 %8llu us   max %8llu us\n",
+            phase.c_str(),
+            static_cast<unsigned long long>(snapshot.count),
+            seconds > 0 ? snapshot.count / seconds : 0.0,
+            static_cast<unsigned long long>(snapshot.p50_us),
+            static_cast<unsigned long long>(snapshot.p90_us),
+            static_cast<unsigned long long>(snapshot.p99_us),
+            static_cast<unsigned long long>(snapshot.max_us));
+    }
+
+    std::map<std::string, std::string> bot_params(const Options& options, int bot_id, long long start, long long end) {
+        std::map<std::string, std::string> params = options.params;
+        params["bot_id"] = std::to_string(bot_id);
+        params["broker_id"] = "1";
+        params["symbol"] = options.symbol;
+        params["interval"] = options.interval;
+        params["start_date"] = std::to_string(start);
+        params["end_date"] = std::to_string(end);
+        if (params.find("money") == params.end()) params["money"] = "1000";
+        return params;
+    }
+
+    // Запуск ботов через BotHandler::start_bot (первый шаг выполняет планировщик)
+    void bench_bot_start(BotHandler& handler, const BacktestResources& resources, const Options& options,
+        long long start, long long end) {
+        LatencyHistogram histogram;
+        auto started = now();
+        {
+            QuietLog quiet;
+            BacktestResources::Scope scope(resources);
+            for (size_t i = 0; i < options.bots; ++i) {
+                int bot_id = static_cast<int>(i) + 1;
+                auto call = now();
+                handler.start_bot(1, bot_id, options.strategy, 1, bot_params(options, bot_id, start, end));
+                histogram.record(since(call));
+            }
+            for (size_t i = 0; i < options.bots; ++i) {
+                handler.stop_bot(static_cast<int>(i) + 1);
+            }
+        }
+        report("bot_start", histogram, since(started));
+    }
+
+    // Торговый цикл: одна цена на раунд, шаги всех ботов параллельно, как в BotScheduler
+    void bench_ticks(BotHandler& handler, const BacktestResources& resources, const Options& options,
+        long long start, long long end) {
+        std::vector<std::shared_ptr<TradeBot>> bots;
+        {
+            BacktestResources::Scope scope(resources);
+            for (size_t i = 0; i < options.bots; ++i) {
+                int bot_id = static_cast<int>(options.bots + i) + 1;
+                bots.push_back(handler.create_backtest_bot(1, bot_id, options.strategy, 1,
+                    bot_params(options, bot_id, start, end)));
+                bots.back()->activate();
+            }
+        }
+
+        ThreadPool pool;
+        LatencyHistogram histogram;
+        auto started = now();
+        for (size_t round = 0; round < options.ticks; ++round) {
+            double price = resources.informer->get_symbol_now(options.symbol);
+            pool.parallel_for(bots.size(), [&](size_t i) {
+                auto call = now();
+                bots[i]->tick(price);
+                histogram.record(since(call));
+                });
+        }
+        report("tick", histogram, since(started));
+        for (auto& bot : bots) bot->stop();
+    }
+
+    // Бэктесты через BotHandler::start_execute_historical из нескольких потоков
+    void bench_backtests(BotHandler& handler, const BacktestResources& resources, const Options& options,
+        long long start, long long end) {
+        LatencyHistogram histogram;
+        std::atomic<size_t> next{ 0 };
+        auto started = now();
+        {
+            QuietLog quiet;
+            std::vector<std::thread> clients;
+            for (size_t c = 0; c < options.clients; ++c) {
+                clients.emplace_back([&]() {
+                    BacktestResources::Scope scope(resources);
+                    for (size_t i = next++; i < options.backtests; i = next++) {
+                        int bot_id = static_cast<int>(100000 + i);
+                        auto call = now();
+                        handler.start_execute_historical(1, bot_id, options.strategy, 1,
+                            bot_params(options, bot_id, start, end));
+                        histogram.record(since(call));
+                    }
+                    });
+            }
+            for (auto& client : clients) client.join();
+        }
+        report("backtest", histogram, since(started));
+    }
+
+    // POST /execute_historical через HttpServer с потоковой выдачей, клиенты держат keep-alive
+    void bench_http(BotHandler& handler, const BacktestResources& resources, const Options& options,
+        long long start, long long end) {
+        net::io_context ioc(1);
+        net::thread_pool workers(std::max(1u, std::thread::hardware_concurrency()));
+
+        auto listener = std::make_shared<HttpListener>(
+            ioc,
+            tcp::endpoint(net::ip::make_address("127.0.0.1"), 0),
+            [&handler, &resources](http::request<http::string_body>& req, http::response<http::string_body>& res,
+                const tcp::endpoint&, ResponseStream& stream) {
+                if (req.target() != "/execute_historical") {
+                    res.result(http::status::not_found);
+                    return;
+                }
+                try {
+                    json body = json::parse(req.body());
+                    std::map<std::string, std::string> params;
+                    for (auto& item : body.items()) {
+                        params[item.key()] = item.value().get<std::string>();
+                    }
+                    std::shared_ptr<TradeBot> bot;
+                    {
+                        BacktestResources::Scope scope(resources);
+                        bot = handler.create_backtest_bot(1, std::stoi(params.at("bot_id")),
+                            std::stoi(params.at("strategy_id")), 1, params);
+                    }
+                    auto candles = std::make_shared<CandleSeries>(bot->load_historical_candles());
+                    res.result(http::status::ok);
+                    res.set(http::field::content_type, "application/json");
+                    stream.start([bot, candles](ChunkedWriter& out) {
+                        bool first = true;
+                        out.write("[", 1);
+                        bot->execute_historical(*candles, [&out, &first, &candles](size_t i, const TradeEvent* trade) {
+                            if (!first) out.write(",", 1);
+                            first = false;
+                            out.write(json{ {"timestamp", std::to_string(candles->timestamp(i))}, {"close", candles->close()[i]},
+                                {"buy", trade_event_json(trade && trade->side == 1 ? trade : nullptr)},
+                                {"sell", trade_event_json(trade && trade->side == -1 ? trade : nullptr)} }.dump());
+                            });
+                        out.write("]", 1);
+                        });
+                }
+                catch (const std::exception& e) {
+                    stream.reset();
+                    res.result(http::status::internal_server_error);
+                    res.body() = e.what();
+                }
+            },
+            [](const http::request<http::string_body>&) { return true; },
+            workers,
+            options.clients); // у каждого клиента не больше одного ответа сразу, отказов 503 в замере нет
+        listener->run();
+        tcp::endpoint endpoint = listener->local_endpoint();
+        std::thread io([&ioc]() { ioc.run(); });
+
+        LatencyHistogram histogram;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> failed{ 0 };
+        auto started = now();
+        {
+            QuietLog quiet;
+            std::vector<std::thread> clients;
+            for (size_t c = 0; c < options.clients; ++c) {
+                clients.emplace_back([&]() {
+                    net::io_context client_ioc;
+                    beast::tcp_stream socket(client_ioc);
+                    socket.connect(endpoint);
+                    beast::flat_buffer buffer;
+                    for (size_t i = next++; i < options.requests; i = next++) {
+                        json body = bot_params(options, static_cast<int>(200000 + i), start, end);
+                        body["strategy_id"] = std::to_string(options.strategy);
+
+                        http::request<http::string_body> req{ http::verb::post, "/execute_historical", 11 };
+                        req.set(http::field::host, "127.0.0.1");
+                        req.set(http::field::content_type, "application/json");
+                        req.keep_alive(true);
+                        req.body() = body.dump();
+                        req.prepare_payload();
+
+                        auto call = now();
+                        http::response_parser<http::string_body> parser;
+                        parser.body_limit(boost::none);
+                        http::write(socket, req);
+                        http::read(socket, buffer, parser);
+                        histogram.record(since(call));
+                        if (parser.get().result() != http::status::ok && failed++ == 0) {
+                            std::cerr << "http: " << parser.get().result_int() << " " << parser.get().body() << std::endl;
+                        }
+                    }
+                    });
+            }
+            for (auto& client : clients) client.join();
+        }
+        report("http", histogram, since(started));
+        if (failed != 0) {
+            std::printf("http: %zu requests failed\n", failed.load());
+        }
+
+        ioc.stop();
+        io.join();
+        workers.join();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    try {
+        options = parse_options(argc, argv);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Invalid arguments: " << e.what() << std::endl;
+        return 2;
+    }
+    long long step = TimeUtils::interval_seconds(options.interval);
+    if (step == 0) {
+        std::cerr << "Unsupported interval: " << options.interval << std::endl;
+        return 2;
+    }
+
+    // Замер не должен зависеть от архива на диске, оставшегося с прошлых прогонов
+    set_env("TRADESNAKE_CANDLE_ARCHIVE_DIR", "off");
+
+    auto informer = std::make_shared<ReplayInformer>(options.replay_dir);
+    if (options.replay_dir.empty()) {
+        informer->add_candles(options.symbol, options.interval, make_synthetic_candles(options.candles, step));
+    }
+    std::vector<CandleData> all = informer->get_symbol_historical(options.symbol, "0",
+        std::to_string(TimeUtils::now_seconds()), options.interval);
+    if (all.empty()) {
+        std::cerr << "No candles for " << options.symbol << " (" << options.interval << ")" << std::endl;
+        return 1;
+    }
+    // Первые свечи оставляем на разгон индикаторов
+    long long start = std::stoll(all[std::min<size_t>(all.size() - 1, 200)].timestamp) / 1000;
+    long long end = std::stoll(all.back().timestamp) / 1000;
+
+    auto broker = std::make_shared<MemoryBroker>(1, 0.0, 0.1, 0.0);
+    BacktestResources resources{ informer, broker };
+    BotHandler handler;
+
+    std::printf("bots=%zu ticks=%zu backtests=%zu requests=%zu clients=%zu candles=%zu strategy=%d\n",
+        options.bots, options.ticks, options.backtests, options.requests, options.clients, all.size(), options.strategy);
+
+    bench_bot_start(handler, resources, options, start, end);
+    bench_ticks(handler, resources, options, start, end);
+    bench_backtests(handler, resources, options, start, end);
+    bench_http(handler, resources, options, start, end);
+
+    std::printf("memory broker: %zu trades, %llu holds\n", broker->trade_count(),
+        static_cast<unsigned long long>(broker->holds()));
+    return 0;
+}
@@ -0,0 +1,297 @@
+﻿// Микробенчмарки горячих путей: индикаторы, анализ рынка, цикл бэктеста и JSON запросов/ответов.
+// Данные - синтетический ряд из памяти (ReplayInformer), сеть и MySQL не нужны.
+//
+//   TradeBotMicroBenchmark [--min-candles 1000] [--max-candles 1000000] [--filter подстрока]
+//                          [--min-time 0.5] [--out micro_benchmark.json]
+//                          [--baseline старый.json] [--threshold 10]
+//
+// Размеры ряда идут от --min-candles до --max-candles с шагом x10 (до 10 000 000 включительно, если хватает памяти).
+// Результаты пишутся в --out; с --baseline каждая строка сравнивается с сохранённой, и замедление больше
+// --threshold процентов помечается как регрессия (код возврата 1).
+
+#include "../BotHandler.hpp"
+#include "../TradeBots/TradeBot.hpp"
+#include "../Analyzers/MarketAnalyzer.hpp"
+#include "../Indicators/Indicator.hpp"
+#include "../Informers/ReplayInformer.hpp"
+#include "../Brokers/MemoryBroker.hpp"
+#include "../Server/RequestJson.hpp"
+#include "../Utils/Logger.hpp"
+#include "./SyntheticCandles.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+namespace {
+
+    struct Options {
+        size_t min_candles = 1000;
+        size_t max_candles = 1000000;
+        std::string filter;
+        double min_time = 0.5;
+        std::string out = "micro_benchmark.json";
+        std::string baseline;
+        double threshold = 10.0;
+    };
+
+    Options parse_options(int argc, char** argv) {
+        Options options;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string name = argv[i];
+            std::string value = argv[i + 1];
+            if (name == "--min-candles") options.min_candles = std::max<size_t>(1, std::stoull(value));
+            else if (name == "--max-candles") options.max_candles = std::stoull(value);
+            else if (name == "--filter") options.filter = value;
+            else if (name == "--min-time") options.min_time = std::stod(value);
+            else if (name == "--out") options.out = value;
+            else if (name == "--baseline") options.baseline = value;
+            else if (name == "--threshold") options.threshold = std::stod(value);
+            else throw std::invalid_argument("Unknown option " + name);
+        }
+        return options;
+    }
+
+    void set_env(const char* name, const char* value) {
+#ifdef _WIN32
+        _putenv_s(name, value);
+#else
+        setenv(name, value, 1);
+#endif
+    }
+
+    // Не даёт компилятору выбросить результат замеряемого кода
+    volatile double sink = 0.0;
+
+    struct Result {
+        std::string name;
+        size_t candles;     // размер входного ряда (0 - не зависит от ряда)
+        size_t items;       // единиц работы за итерацию: свечей или запросов
+        uint64_t iterations;
+        double ns_per_item; // медиана трёх серий
+    };
+
+    // Прогрев, затем три серии по min_time / 3 секунд; берётся медиана времени на единицу работы
+    Result measure(const std::string& name, size_t candles, size_t items, double min_time, const std::function<void()>& body) {
+        using Clock = std::chrono::steady_clock;
+        body();
+
+        std::vector<double> series;
+        uint64_t total_iterations = 0;
+        for (int repetition = 0; repetition < 3; ++repetition) {
+            uint64_t iterations = 0;
+            auto started = Clock::now();
+            std::chrono::duration<double> elapsed{ 0 };
+            do {
+                body();
+                ++iterations;
+                elapsed = Clock::now() - started;
+            } while (elapsed.count() < min_time / 3);
+            total_iterations += iterations;
+            series.push_back(elapsed.count() * 1e9 / static_cast<double>(iterations) / static_cast<double>(std::max<size_t>(1, items)));
+        }
+        std::sort(series.begin(), series.end());
+        return { name, candles, items, total_iterations, series[1] };
+    }
+
+    std::string result_key(const std::string& name, size_t candles) {
+        return name + "/" + std::to_string(candles);
+    }
+
+    // Окружение одного размера ряда: информер с минутными и часовыми свечами, общий для ботов брокер.
+    // Период бэктеста начинается после разгона индикаторов, как в реальных запросах, иначе первые свечи
+    // только пишут предупреждения о нехватке данных
+    struct Fixture {
+        std::shared_ptr<ReplayInformer> informer = std::make_shared<ReplayInformer>();
+        std::shared_ptr<MemoryBroker> broker = std::make_shared<MemoryBroker>(1, 0.0, 0.1, 0.0);
+        CandleSeries minutes;
+        CandleSeries backtest; // минутные свечи периода бэктеста
+        long long start = 0;
+        long long end = 0;
+        long long hours_start = 0;
+
+        Fixture(const std::string& symbol, size_t candles) {
+            minutes = make_synthetic_candles(candles, 60);
+            CandleSeries hours = make_synthetic_candles(candles, 3600);
+            hours_start = hours.timestamp(0) / 1000;
+            informer->add_candles(symbol, "1", minutes);
+            informer->add_candles(symbol, "60", std::move(hours));
+            size_t warmup = std::min<size_t>(200, minutes.size() / 2);
+            backtest.append(minutes, warmup, minutes.size());
+            start = backtest.timestamp(0) / 1000;
+            end = backtest.timestamp(backtest.size() - 1) / 1000;
+        }
+    };
+
+    const char* symbol = "BTCUSDT";
+
+    // Индикатор бэктеста: begin_backtest и значение на каждой свече, как в TradeBot::run_historical
+    void bench_indicator(std::vector<Result>& results, const Options& options, Fixture& fixture, const char* name,
+        const std::function<double(IndicatorsCalc&, const std::string&)>& calculate) {
+        IndicatorsCalc calc(fixture.informer);
+        std::vector<std::string> end_dates;
+        end_dates.reserve(fixture.backtest.size());
+        for (size_t i = 0; i < fixture.backtest.size(); ++i) {
+            end_dates.push_back(std::to_string(fixture.backtest.timestamp(i) / 1000));
+        }
+        results.push_back(measure(name, fixture.minutes.size(), end_dates.size(), options.min_time, [&]() {
+            calc.begin_backtest(fixture.start, fixture.end);
+            double sum = 0.0;
+            for (const auto& end_date : end_dates) sum += calculate(calc, end_date);
+            calc.end_backtest();
+            sink = sum;
+            }));
+    }
+
+    void run_candle_benchmarks(std::vector<Result>& results, const Options& options, size_t candles) {
+        auto enabled = [&options](const std::string& name) {
+            return options.filter.empty() || name.find(options.filter) != std::string::npos;
+        };
+        Fixture fixture(symbol, candles);
+
+        if (enabled("indicators/calculate_ma")) {
+            bench_indicator(results, options, fixture, "indicators/calculate_ma", [](IndicatorsCalc& calc, const std::string& end_date) {
+                return calc.calculate_ma(symbol, 20, "1", end_date);
+                });
+        }
+        if (enabled("indicators/calculate_rsi")) {
+            bench_indicator(results, options, fixture, "indicators/calculate_rsi", [](IndicatorsCalc& calc, const std::string& end_date) {
+                return calc.calculate_rsi(symbol, 14, "1", end_date);
+                });
+        }
+        if (enabled("analyzer/analyze_market")) {
+            MarketAnalyzer analyzer(fixture.informer);
+            std::string start_date = std::to_string(fixture.hours_start);
+            std::string end_date = std::to_string(TimeUtils::now_seconds());
+            results.push_back(measure("analyzer/analyze_market", candles, candles, options.min_time, [&]() {
+                sink = analyzer.analyze_market(symbol, start_date, end_date).volatility;
+                }));
+        }
+
+        BotHandler handler;
+        BacktestResources resources{ fixture.informer, fixture.broker };
+        std::map<std::string, std::string> params = {
+            {"symbol", symbol}, {"interval", "1"}, {"money", "1000"},
+            {"start_date", std::to_string(fixture.start)}, {"end_date", std::to_string(fixture.end)}
+        };
+        auto backtest = std::make_shared<const CandleSeries>(fixture.backtest);
+        HistoricalResult historical;
+        if (enabled("backtest/execute_historical") || enabled("json/historical_result")) {
+            BacktestResources::Scope scope(resources);
+            std::shared_ptr<TradeBot> bot = handler.create_backtest_bot(1, -1, 1, 1, params);
+            if (enabled("backtest/execute_historical")) {
+                results.push_back(measure("backtest/execute_historical", candles, fixture.backtest.size(), options.min_time, [&]() {
+                    sink = static_cast<double>(bot->execute_historical(backtest).trades.size());
+                    }));
+            }
+            historical = handler.create_backtest_bot(1, -1, 1, 1, params)->execute_historical(backtest);
+        }
+        if (enabled("json/historical_result")) {
+            // Сериализация ответа /execute_historical, как в write_array_item
+            results.push_back(measure("json/historical_result", candles, std::max<size_t>(1, backtest->size()), options.min_time, [&]() {
+                size_t bytes = 0;
+                auto trade = historical.trades.begin();
+                for (size_t i = 0; i < backtest->size(); ++i) {
+                    const TradeEvent* event = trade != historical.trades.end() && trade->index == i ? &*trade++ : nullptr;
+                    bytes += historical_candle_json(*backtest, i, event).dump().size();
+                }
+                sink = static_cast<double>(bytes);
+                }));
+        }
+    }
+
+    void run_request_benchmarks(std::vector<Result>& results, const Options& options) {
+        if (!options.filter.empty() && std::string("json/request_params").find(options.filter) == std::string::npos) return;
+        // Типичное тело /execute_historical: разбор, как в обработчике, вместе с параметрами стратегии
+        std::string body = json{
+            {"user_id", 1}, {"strategy_id", 1}, {"broker_id", 1},
+            {"strategy_parameters", {{"symbol", "BTCUSDT"}, {"interval", "1"}, {"money", 1000},
+                {"start_date", "1700000000"}, {"end_date", "1710000000"}, {"ma_length", 20}}}
+        }.dump();
+        results.push_back(measure("json/request_params", 0, 1, options.min_time, [&]() {
+            RequestArena arena;
+            RequestParams params(body);
+            sink = static_cast<double>(params.get_int("user_id") + params.strategy_params().size());
+            }));
+    }
+
+    void write_results(const std::string& path, const std::vector<Result>& results) {
+        json out = json::array();
+        for (const auto& result : results) {
+            out.push_back({
+                {"name", result.name},
+                {"candles", result.candles},
+                {"items", result.items},
+                {"iterations", result.iterations},
+                {"ns_per_item", result.ns_per_item}
+                });
+        }
+        std::ofstream file(path);
+        file << json{ {"results", out} }.dump(2) << std::endl;
+        if (!file) std::cerr << "Cannot write " << path << std::endl;
+    }
+
+    std::map<std::string, double> read_baseline(const std::string& path) {
+        std::map<std::string, double> baseline;
+        std::ifstream file(path);
+        if (!file) throw std::runtime_error("cannot open baseline " + path);
+        json data = json::parse(file);
+        for (const auto& result : data.at("results")) {
+            baseline[result_key(result.at("name").get<std::string>(), result.at("candles").get<size_t>())] =
+                result.at("ns_per_item").get<double>();
+        }
+        return baseline;
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    std::map<std::string, double> baseline;
+    try {
+        options = parse_options(argc, argv);
+        if (!options.baseline.empty()) baseline = read_baseline(options.baseline);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Invalid arguments: " << e.what() << std::endl;
+        return 2;
+    }
+
+    // Архив на диске не участвует, кэш свечей вмещает самый большой ряд обоих интервалов
+    set_env("TRADESNAKE_CANDLE_ARCHIVE_DIR", "off");
+    set_env("TRADESNAKE_CANDLE_CACHE_SIZE", std::to_string(options.max_candles * 4 + 1000).c_str());
+
+    std::vector<Result> results;
+    Logger::getInstance().set_level(LogLevel::Error); // BotHandler и бэктесты пишут время выполнения в журнал
+    run_request_benchmarks(results, options);
+    for (size_t candles = options.min_candles; candles <= options.max_candles; candles *= 10) {
+        run_candle_benchmarks(results, options, candles);
+        CandleCache::getInstance().clear();
+    }
+    Logger::getInstance().flush();
+
+    bool regression = false;
+    std::printf("%-30s %10s %14s %10s\n", "benchmark", "candles", "ns/item", "change");
+    for (const auto& result : results) {
+        std::printf("%-30s %10zu %14.2f", result.name.c_str(), result.candles, result.ns_per_item);
+        auto it = baseline.find(result_key(result.name, result.candles));
+        if (it != baseline.end() && it->second > 0) {
+            double change = (result.ns_per_item / it->second - 1.0) * 100.0;
+            bool slower = change > options.threshold;
+            regression = regression || slower;
+            std::printf(" %+9.1f%%%s", change, slower ? "  REGRESSION" : "");
+        }
+        std::printf("\n");
+    }
+    write_results(options.out, results);
+    return regression ? 1 : 0;
+}
@@ -0,0 +1,33 @@
+#ifndef SYNTHETIC_CANDLES_HPP
+#define SYNTHETIC_CANDLES_HPP
+
+#include "../Data/CandleSeries.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+// Последние count закрытых свечей интервала: случайное блуждание от 100 с шагом ~0.2%.
+// Зерно фиксировано, поэтому прогоны бенчмарков на одной сборке обрабатывают одни и те же цены
+inline CandleSeries make_synthetic_candles(size_t count, long long step, uint64_t seed = 42) {
+    std::mt19937_64 random(seed);
+    std::normal_distribution<double> change(0.0, 0.002);
+    long long last = TimeUtils::align_down(TimeUtils::now_seconds(), step) - step;
+    long long first = last - static_cast<long long>(count == 0 ? 0 : count - 1) * step;
+
+    CandleSeries candles;
+    candles.reserve(count);
+    double price = 100.0;
+    for (size_t i = 0; i < count; ++i) {
+        double open = price;
+        price *= std::exp(change(random));
+        double high = std::max(open, price) * (1.0 + std::abs(change(random)) / 2);
+        double low = std::min(open, price) * (1.0 - std::abs(change(random)) / 2);
+        double volume = 1000.0 + 100.0 * std::abs(change(random)) * 1000;
+        candles.push_back((first + static_cast<long long>(i) * step) * 1000, open, high, low, price, volume, volume * price);
+    }
+    return candles;
+}
+
+#endif // SYNTHETIC_CANDLES_HPP
@@ -4,12 +4,24 @@
 #include "./const.hpp"
 #include "./StrategyFactory.hpp"
 #include "./strategy_registrations.hpp"
+#include "./Optimizers/ParameterSweep.hpp"
+#include "./Optimizers/BatchBacktest.hpp"
+#include "./Schedulers/BotScheduler.hpp"
+#include "./Database/ConnectionPool.hpp"
+#include "./Cache/BrokerMetadataCache.hpp"
+#include "./Utils/Logger.hpp"
+#include "./Utils/Metrics.hpp"
+#include "./Utils/ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <unordered_map>
 #include <functional>
 #include <stdexcept>
 #include <string>
 #include <map>
+#include <vector>
 #include <mutex>
 #include <thread>
 #include <iostream>
@@ -22,208 +34,162 @@
 #include <boost/beast/version.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
-#include <nlohmann/json.hpp> //  nlohmann-json
+#include <nlohmann/json.hpp> // Используем nlohmann-json
 
-//   
+// Предварительные объявления классов
 class TradeBot;
 class Informer;
 
-//      
+// Структура для хранения информации о боте
 struct BotInfo {
     int user_id;
     int bot_id;
-    std::unique_ptr<TradeBot> bot;
+    std::shared_ptr<TradeBot> bot;
 };
 
-//    
+// Строка таблицы bots, разобранная для запуска бота
+struct BotRow {
+    int user_id;
+    int bot_id;
+    int strategy_id;
+    int broker_id;
+    std::map<std::string, std::string> params;
+};
+
+// Ход массового запуска ботов
+struct BotWarmupProgress {
+    size_t total;   // ботов в последнем массовом запуске
+    size_t started;
+    size_t failed;
+};
+
+// Класс для управления ботами
 class BotHandler {
 public:
     BotHandler() {
         registerStrategies();
     }
 
-    //   ,   isRunning = true
+    // Массовый запуск всех ботов с isRunning = true (после рестарта).
+    // Строки ботов читаются одним запросом, комиссии брокеров и типы рынков - другим (в кэш брокеров); информер создаётся
+    // один на тип рынка, брокер - один на broker_id. Боты собираются параллельно в общем пуле потоков,
+    // и их конструкторы не ходят в БД
     inline void initialize_bots() {
+        std::vector<BotRow> rows;
         try {
-            sql::Driver* driver = get_driver_instance();
-            std::unique_ptr<sql::Connection> con(driver->connect(Constants::my_sql_host, Constants::my_sql_login, Constants::my_sql_password));
+            PooledConnection con = ConnectionPool::getInstance().acquire();
             con->setSchema("tradesnake");
 
             std::unique_ptr<sql::Statement> stmt(con->createStatement());
-            std::unique_ptr<sql::ResultSet> res(stmt->executeQuery("SELECT * FROM bots WHERE isRunning = TRUE"));
-
+            std::unique_ptr<sql::ResultSet> res;
+            {
+                ScopedTimer timer(Metrics::sql_latency("select_running_bots"));
+                res.reset(stmt->executeQuery("SELECT * FROM bots WHERE isRunning = TRUE"));
+            }
             while (res->next()) {
-                int bot_id = res->getInt("id");
-                int user_id = res->getInt("user_id");
-                int strategy_id = res->getInt("strategy_id");
-                int broker_id = res->getInt("broker_id");
-                double money = res->getDouble("money");
-                double symbol_count = res->getDouble("symbol_count");
-                std::string symbol = res->getString("symbol");
-
-                //      
-                std::map<std::string, std::string> strategy_params;
-
-                // :    JSON- (     )
-                std::string strategy_params_json = res->getString("strategy_parameters");
-                if (!strategy_params_json.empty()) {
-                    try {
-                        auto json_value = nlohmann::json::parse(strategy_params_json);
-                        if (json_value.is_object()) {
-                            for (auto it = json_value.begin(); it != json_value.end(); ++it) {
-                                const std::string& key = it.key();
-                                const auto& value = it.value();
-
-                                if (value.is_string()) {
-                                    strategy_params[key] = value.get<std::string>();
-                                }
-                                else {
-                                    strategy_params[key] = value.dump(); //   ,    
-                                }
-                            }
-                        }
-                    }
-                    catch (const std::exception& e) {
-                        std::cerr << "Error parsing strategy parameters for bot " << bot_id << ": " << e.what() << std::endl;
-                    }
-                }
-
-                //   
-                strategy_params["bot_id"] = std::to_string(bot_id);
-                strategy_params["broker_id"] = std::to_string(broker_id);
-                strategy_params["money"] = std::to_string(money);
-                strategy_params["symbol_count"] = std::to_string(symbol_count);
-                strategy_params["symbol"] = symbol;
-
-                //  
-                start_bot(user_id, bot_id, strategy_id, broker_id, strategy_params);
+                rows.push_back(read_bot_row(*res));
             }
         }
-        catch (const sql::SQLException& e) {
-            std::cerr << "Error initializing bots: " << e.what() << std::endl;
+        catch (const std::exception& e) {
+            log_error() << "Error initializing bots: " << e.what();
+            return;
         }
+        // Если брокеров загрузить не удалось, каждый бот попробует прочитать своего сам, как при одиночном запуске
+        start_bots(rows, load_broker_resources());
     }
 
-    //      ID
+    // Инициализация одного бота по его ID
     inline void initialize_single_bot(int bot_id) {
         try {
-            sql::Driver* driver = get_driver_instance();
-            std::unique_ptr<sql::Connection> con(driver->connect(Constants::my_sql_host, Constants::my_sql_login, Constants::my_sql_password));
+            PooledConnection con = ConnectionPool::getInstance().acquire();
             con->setSchema("tradesnake");
 
-            std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement("SELECT * FROM bots WHERE id = ? AND isRunning = TRUE"));
+            std::shared_ptr<sql::PreparedStatement> pstmt = con.prepare("SELECT * FROM bots WHERE id = ? AND isRunning = TRUE");
             pstmt->setInt(1, bot_id);
             std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
 
             if (res->next()) {
-                int user_id = res->getInt("user_id");
-                int strategy_id = res->getInt("strategy_id");
-                int broker_id = res->getInt("broker_id");
-                double money = res->getDouble("money");
-                double symbol_count = res->getDouble("symbol_count");
-                std::string symbol = res->getString("symbol");
-
-                //      
-                std::map<std::string, std::string> strategy_params;
-
-                // :    JSON- (     )
-                std::string strategy_params_json = res->getString("strategy_parameters");
-                if (!strategy_params_json.empty()) {
-                    try {
-                        auto json_value = nlohmann::json::parse(strategy_params_json);
-                        if (json_value.is_object()) {
-                            for (auto it = json_value.begin(); it != json_value.end(); ++it) {
-                                const std::string& key = it.key();
-                                const auto& value = it.value();
-
-                                if (value.is_string()) {
-                                    strategy_params[key] = value.get<std::string>();
-                                }
-                                else {
-                                    strategy_params[key] = value.dump(); //   ,    
-                                }
-                            }
-                        }
-                    }
-                    catch (const std::exception& e) {
-                        std::cerr << "Error parsing strategy parameters for bot " << bot_id << ": " << e.what() << std::endl;
-                    }
-                }
-
-                //   
-                strategy_params["bot_id"] = std::to_string(bot_id);
-                strategy_params["broker_id"] = std::to_string(broker_id);
-                strategy_params["money"] = std::to_string(money);
-                strategy_params["symbol_count"] = std::to_string(symbol_count);
-                strategy_params["symbol"] = symbol;
-
-                //  
-                start_bot(user_id, bot_id, strategy_id, broker_id, strategy_params);
+                BotRow row = read_bot_row(*res);
+                start_bot(row.user_id, row.bot_id, row.strategy_id, row.broker_id, row.params);
             }
             else {
-                std::cerr << "Bot " << bot_id << " not found or is not running." << std::endl;
+                log_warn().bot(bot_id) << "Bot " << bot_id << " not found or is not running.";
             }
         }
-        catch (const sql::SQLException& e) {
-            std::cerr << "Error initializing bot " << bot_id << ": " << e.what() << std::endl;
+        catch (const std::exception& e) {
+            log_error().bot(bot_id) << "Error initializing bot " << bot_id << ": " << e.what();
         }
     }
 
 
-    //  
-    inline void start_bot(int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>& strategy_params) {
-        std::unique_ptr<TradeBot> bot;
+    // Запуск бота; false, если бота не удалось создать или поставить в расписание
+    inline bool start_bot(int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>& strategy_params) {
+        std::shared_ptr<TradeBot> bot;
 
         try {
-            //     
-            bot = StrategyFactory::getInstance().createStrategy(strategy_id, user_id, bot_id, broker_id, strategy_params);
+            // Создаём стратегию с использованием параметров (со списком symbols - портфель)
+            bot = StrategyFactory::getInstance().createBot(strategy_id, user_id, bot_id, broker_id, strategy_params);
         }
         catch (const std::exception& e) {
-            std::cerr << "Error creating bot: " << e.what() << std::endl;
-            return;
+            log_error().bot(bot_id).strategy(strategy_id) << "Error creating bot: " << e.what();
+            return false;
         }
 
-        BotInfo bot_info{ user_id, bot_id, std::move(bot) };
+        BotInfo bot_info{ user_id, bot_id, bot };
 
         {
             std::lock_guard<std::mutex> lock(bots_mutex_);
+            auto it = active_bots_.find(bot_id);
+            if (it != active_bots_.end()) {
+                // Повторный запуск того же бота заменяет прежний экземпляр
+                scheduler_.remove(bot_id);
+                it->second.bot->stop();
+            }
             active_bots_[bot_id] = std::move(bot_info);
         }
 
-        std::thread([bot_id, this]() {
-            try {
-                if (active_bots_.find(bot_id) != active_bots_.end()) {
-                    active_bots_[bot_id].bot->start();
-                    std::cout << "Bot " << bot_id << " started successfully." << std::endl;
-                }
-                else {
-                    std::cerr << "Bot " << bot_id << " not found in active bots." << std::endl;
-                }
-            }
-            catch (const std::exception& e) {
-                std::cerr << "Error in bot " << bot_id << " thread: " << e.what() << std::endl;
-            }
-            }).detach();
+        // Шаги бота выполняет планировщик на общем пуле потоков
+        if (!scheduler_.add(bot)) {
+            std::lock_guard<std::mutex> lock(bots_mutex_);
+            active_bots_.erase(bot_id);
+            return false;
+        }
+
+        log_info().bot(bot_id).strategy(strategy_id) << "Bot " << bot_id << " for user " << user_id << " started with strategy " << strategy_id << ".";
+        return true;
+    }
 
-        std::cout << "Bot " << bot_id << " for user " << user_id << " started with strategy " << strategy_id << "." << std::endl;
+    BotWarmupProgress warmup_progress() const {
+        return {
+            warmup_total_.load(std::memory_order_relaxed),
+            warmup_started_.load(std::memory_order_relaxed),
+            warmup_failed_.load(std::memory_order_relaxed)
+        };
     }
 
-    //  
+    // Остановка бота
     inline int stop_bot(int bot_id) {
         std::lock_guard<std::mutex> lock(bots_mutex_);
         auto it = active_bots_.find(bot_id);
         if (it != active_bots_.end()) {
+            scheduler_.remove(bot_id);
             it->second.bot->stop();
             active_bots_.erase(it);
-            std::cout << "Bot " << bot_id << " stopped." << std::endl;
+            log_info().bot(bot_id) << "Bot " << bot_id << " stopped.";
             return 1;
         }
         else {
-            std::cout << "Bot " << bot_id << " not found." << std::endl;
+            log_warn().bot(bot_id) << "Bot " << bot_id << " not found.";
             return 0;
         }
     }
-    std::vector<HistoricalResult> start_execute_historical(
+
+    size_t active_bot_count() {
+        std::lock_guard<std::mutex> lock(bots_mutex_);
+        return active_bots_.size();
+    }
+
+    HistoricalResult start_execute_historical(
         int user_id, int bot_id, int strategy_id, int broker_id,
         const std::map<std::string, std::string>& strategy_params) {
 
@@ -231,13 +197,126 @@ public:
         std::unique_ptr<TradeBot> bot = StrategyFactory::getInstance().createStrategy(
             strategy_id, user_id, bot_id, broker_id, strategy_params);
 
-        std::vector<HistoricalResult> results = bot->execute_historical();
-        return results;
+        return bot->execute_historical();
+    }
+
+    // Бот для бэктеста с потоковой выдачей результата (см. TradeBot::execute_historical с обработчиком)
+    std::shared_ptr<TradeBot> create_backtest_bot(
+        int user_id, int bot_id, int strategy_id, int broker_id,
+        const std::map<std::string, std::string>& strategy_params) {
+        return StrategyFactory::getInstance().createStrategy(strategy_id, user_id, bot_id, broker_id, strategy_params);
+    }
+
+    // Перебор параметров стратегии на одном наборе свечей
+    std::vector<SweepResult> start_optimize(
+        int user_id, int strategy_id, int broker_id,
+        const std::map<std::string, std::string>& strategy_params,
+        const ParameterGrid& grid, const std::string& sort_by, size_t top) {
+        return ParameterSweep::run(user_id, strategy_id, broker_id, strategy_params, grid, sort_by, top);
+    }
+
+    // Пакетный бэктест: задания (символ, период, параметры) параллельно, свечи общие для пересекающихся периодов
+    BatchBacktestResult start_batch_backtest(int user_id, int strategy_id, int broker_id, const std::vector<BacktestJob>& jobs) {
+        return BatchBacktest::run(user_id, strategy_id, broker_id, jobs);
     }
 private:
-    std::map<int, BotInfo> active_bots_;  //  - bot_id
+    std::map<int, BotInfo> active_bots_;  // Ключ - bot_id
     std::mutex bots_mutex_;
+    std::atomic<size_t> warmup_total_{ 0 };
+    std::atomic<size_t> warmup_started_{ 0 };
+    std::atomic<size_t> warmup_failed_{ 0 };
     std::shared_ptr<Informer> informer_;
+    BotScheduler scheduler_; // объявлен последним: останавливается раньше, чем удаляются боты
+
+    // Поля строки bots и параметры стратегии из JSON-столбца strategy_parameters
+    static BotRow read_bot_row(sql::ResultSet& res) {
+        BotRow row;
+        row.bot_id = res.getInt("id");
+        row.user_id = res.getInt("user_id");
+        row.strategy_id = res.getInt("strategy_id");
+        row.broker_id = res.getInt("broker_id");
+        double money = res.getDouble("money");
+        double symbol_count = res.getDouble("symbol_count");
+        std::string symbol = res.getString("symbol");
+
+        std::string strategy_params_json = res.getString("strategy_parameters");
+        if (!strategy_params_json.empty()) {
+            try {
+                auto json_value = nlohmann::json::parse(strategy_params_json);
+                if (json_value.is_object()) {
+                    for (auto it = json_value.begin(); it != json_value.end(); ++it) {
+                        const auto& value = it.value();
+                        // Нестроковые значения храним их JSON-записью
+                        row.params[it.key()] = value.is_string() ? value.get<std::string>() : value.dump();
+                    }
+                }
+            }
+            catch (const std::exception& e) {
+                log_error().bot(row.bot_id) << "Error parsing strategy parameters for bot " << row.bot_id << ": " << e.what();
+            }
+        }
+
+        // Добавляем обязательные параметры
+        row.params["bot_id"] = std::to_string(row.bot_id);
+        row.params["broker_id"] = std::to_string(row.broker_id);
+        row.params["money"] = std::to_string(money);
+        row.params["symbol_count"] = std::to_string(symbol_count);
+        row.params["symbol"] = symbol;
+        return row;
+    }
+
+    // Информер - один на тип рынка, брокер - один на broker_id; данные берутся из свежего снимка кэша брокеров
+    static std::unordered_map<int, BacktestResources> load_broker_resources() {
+        std::unordered_map<int, BacktestResources> resources;
+        BrokerMetadataCache& cache = BrokerMetadataCache::getInstance();
+        if (!cache.refresh()) return resources;
+
+        std::map<std::string, std::shared_ptr<Informer>> informers;
+        for (const auto& item : *cache.snapshot()) {
+            std::shared_ptr<Informer>& informer = informers[item.second.market_type_name];
+            if (!informer) informer = TradeBot::make_informer(item.second.market_type_name);
+            resources[item.first] = { informer, std::make_shared<Broker>(item.first) };
+        }
+        return resources;
+    }
+
+    // Параллельный запуск; бот брокера, которого нет в resources, читает данные из БД сам
+    void start_bots(const std::vector<BotRow>& rows, const std::unordered_map<int, BacktestResources>& resources) {
+        auto started_at = std::chrono::steady_clock::now();
+        warmup_total_.store(rows.size());
+        warmup_started_.store(0);
+        warmup_failed_.store(0);
+        ThreadPool& pool = ThreadPool::shared();
+        log_info() << "Starting " << rows.size() << " bots (" << resources.size() << " brokers) on "
+            << pool.size() << " threads";
+
+        // Ход запуска - каждые 10% ботов
+        const size_t report_every = std::max<size_t>(1, rows.size() / 10);
+        std::atomic<size_t> finished{ 0 };
+        pool.parallel_for(rows.size(), [&](size_t i) {
+            const BotRow& row = rows[i];
+            bool started;
+            auto shared = resources.find(row.broker_id);
+            if (shared != resources.end()) {
+                BacktestResources::Scope scope(shared->second);
+                started = start_bot(row.user_id, row.bot_id, row.strategy_id, row.broker_id, row.params);
+            }
+            else {
+                started = start_bot(row.user_id, row.bot_id, row.strategy_id, row.broker_id, row.params);
+            }
+            (started ? warmup_started_ : warmup_failed_).fetch_add(1, std::memory_order_relaxed);
+
+            size_t done = finished.fetch_add(1) + 1;
+            if (done % report_every == 0 && done != rows.size()) {
+                auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_at);
+                log_info() << "Bot warm-up: " << done << "/" << rows.size() << " bots in " << elapsed.count() << " ms";
+            }
+            });
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_at);
+        log_info() << "Bot warm-up finished: " << warmup_started_.load() << " started, " << warmup_failed_.load()
+            << " failed in " << elapsed.count() << " ms";
+    }
 };
 
 #endif // BOT_HANDLER_HPP
\ No newline at end of file
@@ -1,137 +1,265 @@
 #ifndef BROKER_HPP
 #define BROKER_HPP
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <string>
 #include <memory>
+#include <thread>
+#include <vector>
 #include <mysql/jdbc.h>
 #include "./const.hpp"
+#include "../Database/ConnectionPool.hpp"
+#include "../Cache/BrokerMetadataCache.hpp"
+#include "./PriceUpdateQueue.hpp"
+#include "../Utils/LatencyHistogram.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Logger.hpp"
+
+// Счётчики записи сделок
+struct TradeCommitStats {
+    LatencyHistogram latency;     // от начала первой попытки до успешного COMMIT
+    std::atomic<uint64_t> retries{ 0 };
+    std::atomic<uint64_t> failures{ 0 };
+};
+
+// Сделка, которую бот решил совершить на шаге; пишется брокером (см. Broker::commit)
+struct TradeOrder {
+    int type_id; // 1 - покупка, 2 - продажа
+    double current_price;
+    double real_price;
+    double quantity;
+};
+
+// Счёт портфельного бота после сделок шага: деньги по всем символам и позиции по каждому (JSON)
+struct PortfolioAccount {
+    double money;
+    double symbol_count;
+    std::string positions_json;
+};
 
 class Broker {
 private:
-    double spred;
-    double procent_comission;
-    double fix_comission;
+    static constexpr int max_commit_attempts = 3;
+
+    BrokerFees fees_;  // заданные при создании или последние известные из кэша
+    bool cached_fees_; // комиссии читаются из BrokerMetadataCache и меняются вместе с таблицей brokers
     int broker_id;
-    std::shared_ptr<sql::Connection> con;
 
-    //         
-    void fetchBrokerData() {
-        if (!con) {
-            std::cerr << "Database connection is not established!" << std::endl;
-            return;
+    // Соединение из общего пула на время одной операции
+    PooledConnection acquireConnection() {
+        try {
+            return ConnectionPool::getInstance().acquire();
         }
+        catch (const std::exception& e) {
+            log_error() << "Database connection is not established: " << e.what();
+            return PooledConnection();
+        }
+    }
 
-        try {
-            std::shared_ptr<sql::PreparedStatement> pstmt(
-                con->prepareStatement("SELECT spred, procent_comission, fox_comission FROM brokers WHERE id = ?")
-            );
-            pstmt->setInt(1, broker_id);
+    // Актуальные комиссии: из снимка кэша без блокировок, а если брокер из него пропал - последние известные
+    BrokerFees fees() const {
+        BrokerFees current = fees_;
+        if (cached_fees_) BrokerMetadataCache::getInstance().fees(broker_id, current);
+        return current;
+    }
+
+    // Текущая цена пишется через отложенную очередь: при частых тиках в базу уходит только последняя
+    void updateCurrentPrice(int bot_id, double current_price) {
+        PriceUpdateQueue::getInstance().enqueue(bot_id, current_price);
+    }
+
+    // Транзакция write(con) целиком; при взаимной блокировке повторяем. operation - для журнала ошибок
+    template <typename Write>
+    bool runTransaction(const char* operation, Write&& write) {
+        TradeCommitStats& stats = commitStats();
+        auto started = std::chrono::steady_clock::now();
 
-            std::shared_ptr<sql::ResultSet> res(pstmt->executeQuery());
+        for (int attempt = 1; attempt <= max_commit_attempts; ++attempt) {
+            PooledConnection con = acquireConnection();
+            if (!con) {
+                stats.failures.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            try {
+                con->setAutoCommit(false);
+                write(con);
+                {
+                    static ShardedHistogram& latency = Metrics::sql_latency("commit_trade");
+                    ScopedTimer timer(latency);
+                    con->commit();
+                }
+                con->setAutoCommit(true);
 
-            if (res->next()) {
-                spred = res->getDouble("spred");
-                procent_comission = res->getDouble("procent_comission");
-                fix_comission = res->getDouble("fox_comission"); 
+                stats.latency.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - started));
+                return true;
             }
-            else {
-                std::cerr << "Broker with id " << broker_id << " not found!" << std::endl;
+            catch (sql::SQLException& e) {
+                con.on_error(e);
+                rollback(con);
+                if (isRetryable(e) && attempt < max_commit_attempts) {
+                    stats.retries.fetch_add(1, std::memory_order_relaxed);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10 * attempt));
+                    continue;
+                }
+                stats.failures.fetch_add(1, std::memory_order_relaxed);
+                log_error() << "Error during " << operation << " operation: " << e.what();
+                return false;
+            }
+            catch (...) {
+                // Соединение с незавершённой транзакцией не должно вернуться в пул
+                stats.failures.fetch_add(1, std::memory_order_relaxed);
+                rollback(con);
+                con.invalidate();
+                throw;
             }
         }
-        catch (const sql::SQLException& e) {
-            std::cerr << "SQL Error: " << e.what() << std::endl;
-        }
+        return false;
     }
 
-
-
-public:
-    Broker(int broker_id)
-        : broker_id(broker_id), spred(0), procent_comission(0), fix_comission(0) {
-        con = Constants::createConnection();
-        fetchBrokerData();  
+    // Запись сделки и изменение баланса бота одной транзакцией
+    bool commitTrade(int bot_id, int type_id, double current_price, double real_price, double quantity) {
+        bool committed = runTransaction(type_id == 1 ? "BUY" : "SELL", [&](PooledConnection& con) {
+            writeTrade(con, bot_id, type_id, current_price, real_price, quantity);
+            });
+        if (committed) updateCurrentPrice(bot_id, real_price);
+        return committed;
     }
-    double calculateRealPriceSell(double current_price,double quantity) {
-        double real_price = (current_price * quantity - spred - (procent_comission / 100.0 * current_price * quantity) - fix_comission)/quantity;
-        return real_price;
+
+    // Сделки всех символов портфеля за шаг и итоговый счёт бота одной транзакцией
+    bool commitPortfolio(int bot_id, const std::vector<TradeOrder>& orders, const PortfolioAccount& account) {
+        return runTransaction("PORTFOLIO", [&](PooledConnection& con) {
+            for (const TradeOrder& order : orders) {
+                insertTrade(con, bot_id, order.type_id, order.current_price, order.real_price, order.quantity);
+            }
+            // Строку бота пишет только сам портфель, поэтому счёт записывается целиком, а не приращениями
+            std::shared_ptr<sql::PreparedStatement> pstmt = con.prepare(
+                "UPDATE bots SET money = ?, symbol_count = ?, "
+                "strategy_parameters = JSON_SET(COALESCE(strategy_parameters, JSON_OBJECT()), '$.positions', CAST(? AS JSON)) "
+                "WHERE id = ?");
+            pstmt->setDouble(1, account.money);
+            pstmt->setDouble(2, account.symbol_count);
+            pstmt->setString(3, account.positions_json);
+            pstmt->setInt(4, bot_id);
+            static ShardedHistogram& latency = Metrics::sql_latency("update_bot_portfolio");
+            ScopedTimer timer(latency);
+            pstmt->executeUpdate();
+            });
     }
-    double calculateRealPriceBuy(double current_price, double quantity) {
-        double real_price = (current_price * quantity + spred + (procent_comission / 100.0 * current_price * quantity) + fix_comission) / quantity;
-        return real_price;
+
+    void insertTrade(PooledConnection& con, int bot_id, int type_id, double current_price, double real_price, double quantity) {
+        std::shared_ptr<sql::PreparedStatement> pstmt =
+            con.prepare("INSERT INTO trades (bot_id, type_id, price, price_by_broker, quantity, time) VALUES (?, ?, ?, ?, ?, NOW())");
+        pstmt->setInt(1, bot_id);
+        pstmt->setInt(2, type_id);
+        pstmt->setDouble(3, current_price * quantity);
+        pstmt->setDouble(4, real_price * quantity);
+        pstmt->setDouble(5, quantity);
+        static ShardedHistogram& latency = Metrics::sql_latency("insert_trade");
+        ScopedTimer timer(latency);
+        pstmt->executeUpdate();
     }
-    void sell(int bot_id, double current_price,double real_price, double quantity) {
-        std::shared_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO trades (bot_id, type_id, price, price_by_broker, quantity, time) VALUES (?, ?, ?, ?, ?, NOW())")
-        );
-        try {
-            hold(bot_id, real_price);
-            pstmt->setInt(1, bot_id);
-            pstmt->setInt(2, 2);  
-            pstmt->setDouble(3, current_price* quantity);
-            pstmt->setDouble(4, real_price * quantity);
-            pstmt->setDouble(5, quantity);
 
-            pstmt->executeUpdate();
+    void writeTrade(PooledConnection& con, int bot_id, int type_id, double current_price, double real_price, double quantity) {
+        insertTrade(con, bot_id, type_id, current_price, real_price, quantity);
 
-            //    
-            std::shared_ptr<sql::PreparedStatement> update_pstmt(
-                con->prepareStatement("UPDATE bots SET money = money + ?, symbol_count = 0 WHERE id = ?")
-            );
-            update_pstmt->setDouble(1, quantity * current_price); //  
-            update_pstmt->setInt(2, bot_id);  //    
+        // Обновляем информацию о боте
+        if (type_id == 1) {
+            std::shared_ptr<sql::PreparedStatement> update_pstmt =
+                con.prepare("UPDATE bots SET money = money - ?, symbol_count = symbol_count + ? WHERE id = ?");
+            update_pstmt->setDouble(1, quantity * current_price); // Снимаем деньги
+            update_pstmt->setDouble(2, quantity); // Увеличиваем количество символов
+            update_pstmt->setInt(3, bot_id);
+            static ShardedHistogram& latency = Metrics::sql_latency("update_bot_buy");
+            ScopedTimer timer(latency);
             update_pstmt->executeUpdate();
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "Error during SELL operation: " << e.what() << std::endl;
+        else {
+            std::shared_ptr<sql::PreparedStatement> update_pstmt =
+                con.prepare("UPDATE bots SET money = money + ?, symbol_count = 0 WHERE id = ?");
+            update_pstmt->setDouble(1, quantity * current_price); // Добавляем деньги
+            update_pstmt->setInt(2, bot_id);
+            static ShardedHistogram& latency = Metrics::sql_latency("update_bot_sell");
+            ScopedTimer timer(latency);
+            update_pstmt->executeUpdate();
         }
     }
-    void hold(int bot_id, double current_price) {
+
+    // Соединение с незавершённой транзакцией в пул не возвращаем
+    static void rollback(PooledConnection& con) {
         try {
-            std::shared_ptr<sql::PreparedStatement> pstmt(
-                con->prepareStatement("UPDATE bots SET current_price = ? WHERE id = ?")
-            );
-            pstmt->setDouble(1, current_price);
-            pstmt->setInt(2, bot_id);
-            pstmt->executeUpdate();
+            con->rollback();
+            con->setAutoCommit(true);
         }
         catch (sql::SQLException& e) {
-            std::cerr << "Error during HOLD operation: " << e.what() << std::endl;
+            log_error() << "Rollback failed: " << e.what();
+            con.invalidate();
         }
     }
 
-    void buy(int bot_id, double current_price, double real_price, double quantity) {
-        std::shared_ptr<sql::PreparedStatement> pstmt(
-            con->prepareStatement("INSERT INTO trades (bot_id, type_id, price, price_by_broker, quantity, time) VALUES (?, ?, ?, ?, ?, NOW())")
-        );
-        try {
-            hold(bot_id, real_price);
-            pstmt->setInt(1, bot_id);
-            pstmt->setInt(2, 1); 
-            pstmt->setDouble(3, current_price*quantity);
-            pstmt->setDouble(4, real_price * quantity);
-            pstmt->setDouble(5, quantity);
-
-            pstmt->executeUpdate();
+    // 1213 - взаимная блокировка, 1205 - таймаут ожидания блокировки
+    static bool isRetryable(const sql::SQLException& e) {
+        return e.getErrorCode() == 1213 || e.getErrorCode() == 1205;
+    }
 
-            //    
-            std::shared_ptr<sql::PreparedStatement> update_pstmt(
-                con->prepareStatement("UPDATE bots SET money = money - ?, symbol_count = symbol_count + ? WHERE id = ?")
-            );
-            update_pstmt->setDouble(1, quantity * current_price); //  
-            update_pstmt->setDouble(2, quantity); //   
-            update_pstmt->setInt(3, bot_id);  //    
-            update_pstmt->executeUpdate();
+public:
+    // Комиссии из общего кэша брокеров (таблица brokers читается один раз на всех ботов)
+    Broker(int broker_id)
+        : cached_fees_(true), broker_id(broker_id) {
+        BrokerMetadata metadata;
+        if (BrokerMetadataCache::getInstance().find(broker_id, metadata)) {
+            fees_ = metadata.fees;
         }
-        catch (sql::SQLException& e) {
-            std::cerr << "Error during BUY operation: " << e.what() << std::endl;
+        else {
+            log_error() << "Broker with id " << broker_id << " not found!";
         }
     }
+    // Брокер с заданными комиссиями, без запроса к БД
+    Broker(int broker_id, double spred, double procent_comission, double fix_comission)
+        : fees_{ spred, procent_comission, fix_comission }, cached_fees_(false), broker_id(broker_id) {
+    }
+    virtual ~Broker() = default;
+
+    double calculateRealPriceSell(double current_price,double quantity) {
+        BrokerFees fee = fees();
+        double real_price = (current_price * quantity - fee.spred - (fee.procent_comission / 100.0 * current_price * quantity) - fee.fix_comission)/quantity;
+        return real_price;
+    }
+    double calculateRealPriceBuy(double current_price, double quantity) {
+        BrokerFees fee = fees();
+        double real_price = (current_price * quantity + fee.spred + (fee.procent_comission / 100.0 * current_price * quantity) + fee.fix_comission) / quantity;
+        return real_price;
+    }
+    // false - сделка не записана, баланс бота в БД не изменился
+    virtual bool sell(int bot_id, double current_price,double real_price, double quantity) {
+        return commitTrade(bot_id, 2, current_price, real_price, quantity);
+    }
+    // Сделки нет - соединение не нужно, цена уйдёт в базу со следующей пачкой
+    virtual void hold(int bot_id, double current_price) {
+        updateCurrentPrice(bot_id, current_price);
+    }
+
+    virtual bool buy(int bot_id, double current_price, double real_price, double quantity) {
+        return commitTrade(bot_id, 1, current_price, real_price, quantity);
+    }
+
+    // Сделки портфельного бота за один шаг: одно соединение и одна транзакция на все символы
+    virtual bool commit(int bot_id, const std::vector<TradeOrder>& orders, const PortfolioAccount& account) {
+        return commitPortfolio(bot_id, orders, account);
+    }
+
+    static TradeCommitStats& commitStats() {
+        static TradeCommitStats stats;
+        return stats;
+    }
 
-    //      
-    double getSpred() const { return spred; }
-    double getProcentComission() const { return procent_comission; }
-    double getFixComission() const { return fix_comission; }
+    // Геттеры для доступа к данным брокера
+    double getSpred() const { return fees().spred; }
+    double getProcentComission() const { return fees().procent_comission; }
+    double getFixComission() const { return fees().fix_comission; }
 };
 
 #endif
\ No newline at end of file
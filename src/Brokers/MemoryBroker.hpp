@@ -0,0 +1,92 @@
+#ifndef MEMORY_BROKER_HPP
+#define MEMORY_BROKER_HPP
+
+#include "./Broker.hpp"
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Сделка, записанная MemoryBroker (суммы как в таблице trades: цена * количество)
+struct MemoryTrade {
+    int bot_id;
+    int type_id; // 1 - покупка, 2 - продажа
+    double price;
+    double price_by_broker;
+    double quantity;
+};
+
+// Брокер без базы данных: сделки и текущие цены ботов копятся в памяти.
+// Используется при воспроизведении записанных данных и в бенчмарках, где MySQL нет.
+class MemoryBroker : public Broker {
+public:
+    MemoryBroker(int broker_id, double spred = 0, double procent_comission = 0, double fix_comission = 0)
+        : Broker(broker_id, spred, procent_comission, fix_comission) {
+    }
+
+    bool buy(int bot_id, double current_price, double real_price, double quantity) override {
+        record(bot_id, 1, current_price, real_price, quantity);
+        return true;
+    }
+
+    bool sell(int bot_id, double current_price, double real_price, double quantity) override {
+        record(bot_id, 2, current_price, real_price, quantity);
+        return true;
+    }
+
+    bool commit(int bot_id, const std::vector<TradeOrder>& orders, const PortfolioAccount&) override {
+        for (const TradeOrder& order : orders) {
+            record(bot_id, order.type_id, order.current_price, order.real_price, order.quantity);
+        }
+        return true;
+    }
+
+    void hold(int bot_id, double current_price) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        prices_[bot_id] = current_price;
+        ++holds_;
+    }
+
+    std::vector<MemoryTrade> trades() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return trades_;
+    }
+
+    size_t trade_count() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return trades_.size();
+    }
+
+    uint64_t holds() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return holds_;
+    }
+
+    // Последняя цена бота (0, если бот ещё не торговал)
+    double current_price(int bot_id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = prices_.find(bot_id);
+        return it != prices_.end() ? it->second : 0.0;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trades_.clear();
+        prices_.clear();
+        holds_ = 0;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<MemoryTrade> trades_;
+    std::unordered_map<int, double> prices_;
+    uint64_t holds_ = 0;
+
+    void record(int bot_id, int type_id, double current_price, double real_price, double quantity) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trades_.push_back({ bot_id, type_id, current_price * quantity, real_price * quantity, quantity });
+        prices_[bot_id] = real_price;
+    }
+};
+
+#endif // MEMORY_BROKER_HPP
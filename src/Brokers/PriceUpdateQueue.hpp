@@ -0,0 +1,168 @@
+#ifndef PRICE_UPDATE_QUEUE_HPP
+#define PRICE_UPDATE_QUEUE_HPP
+
+#include "../Database/ConnectionPool.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Logger.hpp"
+#include <mysql/jdbc.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Отложенная запись bots.current_price: обновления одного бота склеиваются (остаётся последняя цена),
+// раз в flush_interval накопленное уходит в базу многострочными UPDATE.
+// Сделки и баланс сюда не попадают - они пишутся сразу.
+class PriceUpdateQueue {
+public:
+    static constexpr size_t max_rows_per_statement = 200;
+
+    static PriceUpdateQueue& getInstance() {
+        static PriceUpdateQueue instance;
+        return instance;
+    }
+
+    ~PriceUpdateQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (flusher_.joinable()) flusher_.join();
+        flush();
+    }
+
+    // Более новая цена бота заменяет ещё не записанную
+    void enqueue(int bot_id, double current_price) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_[bot_id] = current_price;
+        enqueued_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Синхронно записывает всё накопленное
+    void flush() {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+        std::map<int, double> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.swap(pending_);
+        }
+        if (batch.empty()) return;
+
+        try {
+            PooledConnection con = ConnectionPool::getInstance().acquire();
+            auto it = batch.begin();
+            while (it != batch.end()) {
+                size_t rows = std::min<size_t>(max_rows_per_statement, std::distance(it, batch.end()));
+                auto chunk_end = std::next(it, rows);
+                write_chunk(con, it, chunk_end, rows);
+                flushed_rows_.fetch_add(rows, std::memory_order_relaxed);
+                statements_.fetch_add(1, std::memory_order_relaxed);
+                it = batch.erase(it, chunk_end);
+            }
+        }
+        catch (const std::exception& e) {
+            log_error() << "Error flushing bot prices: " << e.what();
+            // Незаписанные цены возвращаем в очередь, если их ещё не заменили более новые
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& item : batch) {
+                pending_.emplace(item.first, item.second);
+            }
+        }
+    }
+
+    size_t pending() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_.size();
+    }
+
+    uint64_t enqueued() const { return enqueued_.load(std::memory_order_relaxed); }
+    uint64_t flushed_rows() const { return flushed_rows_.load(std::memory_order_relaxed); }
+    uint64_t statements() const { return statements_.load(std::memory_order_relaxed); }
+
+private:
+    mutable std::mutex mutex_;
+    std::mutex flush_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::map<int, double> pending_; // упорядочено по id - строки блокируются в одном порядке
+    std::chrono::milliseconds flush_interval_{ 500 };
+    std::atomic<uint64_t> enqueued_{ 0 };
+    std::atomic<uint64_t> flushed_rows_{ 0 };
+    std::atomic<uint64_t> statements_{ 0 };
+    std::thread flusher_;
+
+    PriceUpdateQueue() {
+        // Пул должен пережить очередь: при завершении она ещё пишет остаток
+        ConnectionPool::getInstance();
+
+        const char* value = std::getenv("TRADESNAKE_PRICE_FLUSH_MS");
+        if (value != nullptr) {
+            try {
+                flush_interval_ = std::chrono::milliseconds(std::max(10L, std::stol(value)));
+            }
+            catch (const std::exception&) {
+                log_warn() << "Invalid value of TRADESNAKE_PRICE_FLUSH_MS: " << value;
+            }
+        }
+        flusher_ = std::thread([this]() { flush_loop(); });
+    }
+
+    PriceUpdateQueue(const PriceUpdateQueue&) = delete;
+    PriceUpdateQueue& operator=(const PriceUpdateQueue&) = delete;
+
+    void flush_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wake_.wait_for(lock, flush_interval_, [this]() { return stopping_; });
+            if (stopping_) break;
+            lock.unlock();
+            flush();
+            lock.lock();
+        }
+    }
+
+    // UPDATE bots SET current_price = CASE id WHEN ? THEN ? ... END WHERE id IN (?, ...)
+    static void write_chunk(PooledConnection& con, std::map<int, double>::const_iterator begin,
+        std::map<int, double>::const_iterator end, size_t rows) {
+        // Число строк округляется вверх до степени двойки повтором последней строки,
+        // чтобы в кэше соединения было несколько текстов запроса, а не по одному на каждый размер
+        size_t slots = 1;
+        while (slots < rows) slots *= 2;
+        slots = std::min(slots, max_rows_per_statement);
+
+        std::string query = "UPDATE bots SET current_price = CASE id";
+        for (size_t i = 0; i < slots; ++i) query += " WHEN ? THEN ?";
+        query += " END WHERE id IN (";
+        for (size_t i = 0; i < slots; ++i) query += i == 0 ? "?" : ", ?";
+        query += ")";
+
+        std::vector<std::pair<int, double>> values(begin, end);
+        values.resize(slots, values.back());
+
+        std::shared_ptr<sql::PreparedStatement> pstmt = con.prepare(query);
+        int index = 1;
+        for (const auto& value : values) {
+            pstmt->setInt(index++, value.first);
+            pstmt->setDouble(index++, value.second);
+        }
+        for (const auto& value : values) {
+            pstmt->setInt(index++, value.first);
+        }
+        static ShardedHistogram& latency = Metrics::sql_latency("update_current_price");
+        ScopedTimer timer(latency);
+        pstmt->executeUpdate();
+    }
+};
+
+#endif // PRICE_UPDATE_QUEUE_HPP
@@ -0,0 +1,237 @@
+#ifndef BROKER_METADATA_CACHE_HPP
+#define BROKER_METADATA_CACHE_HPP
+
+#include "../Database/ConnectionPool.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Logger.hpp"
+#include <mysql/jdbc.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// Комиссии брокера
+struct BrokerFees {
+    double spred = 0;
+    double procent_comission = 0;
+    double fix_comission = 0;
+};
+
+// Строка brokers вместе с типом рынка брокера (markets -> markettypes)
+struct BrokerMetadata {
+    BrokerFees fees;
+    std::string market_type_name;
+};
+
+using BrokerMetadataMap = std::unordered_map<int, BrokerMetadata>; // ключ - broker_id
+
+// Счётчики кэша брокеров
+struct BrokerMetadataStats {
+    uint64_t version;   // номер снимка; 0 - данные ещё не загружены
+    size_t brokers;
+    uint64_t refreshes; // удачных загрузок
+    uint64_t failures;
+    int64_t age_ms;     // возраст текущего снимка; -1, если его нет
+};
+
+// Общий кэш брокеров и типов рынков: таблицы загружаются целиком одним запросом и раздаются неизменяемыми
+// снимками. Каждый поток держит свою ссылку на снимок и берёт новую, только когда изменился номер версии,
+// поэтому чтение комиссий в торговом цикле обходится без блокировок. Снимок перечитывается раз в
+// TRADESNAKE_BROKER_CACHE_TTL секунд, по запросу POST /broker_cache_refresh и при обращении к неизвестному брокеру.
+class BrokerMetadataCache {
+public:
+    static BrokerMetadataCache& getInstance() {
+        static BrokerMetadataCache instance;
+        return instance;
+    }
+
+    ~BrokerMetadataCache() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (refresher_.joinable()) refresher_.join();
+    }
+
+    // Комиссии для торгового цикла: без блокировок и без обращения к БД; false, если брокера в снимке нет
+    bool fees(int broker_id, BrokerFees& out) {
+        const BrokerMetadataMap& brokers = *local_snapshot();
+        auto it = brokers.find(broker_id);
+        if (it == brokers.end()) return false;
+        out = it->second.fees;
+        return true;
+    }
+
+    // Данные брокера при создании бота: первый вызов загружает снимок, неизвестный брокер
+    // вызывает перечитывание (не чаще раза в секунду), чтобы новые строки brokers подхватывались без перезапуска
+    bool find(int broker_id, BrokerMetadata& out) {
+        if (version_.load(std::memory_order_acquire) == 0 || !contains(broker_id)) {
+            refresh_if_stale(std::chrono::seconds(1));
+        }
+        const BrokerMetadataMap& brokers = *local_snapshot();
+        auto it = brokers.find(broker_id);
+        if (it == brokers.end()) return false;
+        out = it->second;
+        return true;
+    }
+
+    // Текущий снимок целиком (пустой, если данные ещё не загружены)
+    std::shared_ptr<const BrokerMetadataMap> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    // Синхронно перечитывает таблицы; при ошибке остаётся прежний снимок
+    bool refresh() {
+        std::lock_guard<std::mutex> refresh_lock(refresh_mutex_);
+        return reload();
+    }
+
+    BrokerMetadataStats get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t version = version_.load(std::memory_order_relaxed);
+        return {
+            version,
+            current_->size(),
+            refreshes_.load(std::memory_order_relaxed),
+            failures_.load(std::memory_order_relaxed),
+            version == 0 ? -1 : static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - loaded_at_).count())
+        };
+    }
+
+private:
+    mutable std::mutex mutex_;    // current_, loaded_at_, refresher_, stopping_
+    std::mutex refresh_mutex_;    // одна загрузка за раз; защищает attempted_at_
+    std::chrono::steady_clock::time_point attempted_at_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::shared_ptr<const BrokerMetadataMap> current_ = std::make_shared<BrokerMetadataMap>();
+    std::chrono::steady_clock::time_point loaded_at_;
+    std::atomic<uint64_t> version_{ 0 };
+    std::atomic<uint64_t> refreshes_{ 0 };
+    std::atomic<uint64_t> failures_{ 0 };
+    std::chrono::seconds ttl_{ 300 };
+    std::thread refresher_;
+
+    BrokerMetadataCache() {
+        // Пул должен пережить кэш: фоновое обновление может идти до самого завершения
+        ConnectionPool::getInstance();
+
+        const char* value = std::getenv("TRADESNAKE_BROKER_CACHE_TTL");
+        if (value != nullptr) {
+            try {
+                ttl_ = std::chrono::seconds(std::max(0L, std::stol(value)));
+            }
+            catch (const std::exception&) {
+                log_warn() << "Invalid value of TRADESNAKE_BROKER_CACHE_TTL: " << value;
+            }
+        }
+    }
+
+    BrokerMetadataCache(const BrokerMetadataCache&) = delete;
+    BrokerMetadataCache& operator=(const BrokerMetadataCache&) = delete;
+
+    // Снимок, закреплённый за потоком; блокировка берётся только после смены версии
+    const BrokerMetadataMap* local_snapshot() {
+        thread_local std::shared_ptr<const BrokerMetadataMap> local;
+        thread_local uint64_t local_version = 0;
+        uint64_t version = version_.load(std::memory_order_acquire);
+        if (!local || version != local_version) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            local = current_;
+            local_version = version_.load(std::memory_order_relaxed);
+        }
+        return local.get();
+    }
+
+    bool contains(int broker_id) {
+        return local_snapshot()->count(broker_id) != 0;
+    }
+
+    // Перечитывание, если последняя попытка была раньше max_age; параллельные вызовы ждут одну загрузку
+    void refresh_if_stale(std::chrono::steady_clock::duration max_age) {
+        uint64_t seen = version_.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> refresh_lock(refresh_mutex_);
+        if (version_.load(std::memory_order_acquire) != seen) return; // пока ждали, данные уже перечитали
+        auto now = std::chrono::steady_clock::now();
+        if (attempted_at_ != std::chrono::steady_clock::time_point() && now - attempted_at_ < max_age) return;
+        reload();
+    }
+
+    // Загрузка нового снимка; вызывается под refresh_mutex_
+    bool reload() {
+        attempted_at_ = std::chrono::steady_clock::now();
+        std::shared_ptr<BrokerMetadataMap> loaded;
+        try {
+            loaded = load();
+        }
+        catch (const std::exception& e) {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            log_error() << "Error loading brokers: " << e.what();
+            return false;
+        }
+
+        size_t count = loaded->size();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            current_ = std::move(loaded);
+            loaded_at_ = std::chrono::steady_clock::now();
+            version_.fetch_add(1, std::memory_order_release);
+            if (!refresher_.joinable() && ttl_.count() > 0) {
+                refresher_ = std::thread([this]() { refresh_loop(); });
+            }
+        }
+        refreshes_.fetch_add(1, std::memory_order_relaxed);
+        log_debug() << "Broker metadata loaded: " << count << " brokers";
+        return true;
+    }
+
+    void refresh_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wake_.wait_for(lock, ttl_, [this]() { return stopping_; });
+            if (stopping_) break;
+            lock.unlock();
+            refresh();
+            lock.lock();
+        }
+    }
+
+    static std::shared_ptr<BrokerMetadataMap> load() {
+        PooledConnection con = ConnectionPool::getInstance().acquire();
+        con->setSchema("tradesnake");
+        std::unique_ptr<sql::Statement> stmt(con->createStatement());
+        std::unique_ptr<sql::ResultSet> res;
+        {
+            static ShardedHistogram& latency = Metrics::sql_latency("select_brokers_with_market_types");
+            ScopedTimer timer(latency);
+            res.reset(stmt->executeQuery(
+                "SELECT brokers.id, brokers.spred, brokers.procent_comission, brokers.fox_comission, "
+                "markettypes.market_type_name "
+                "FROM brokers "
+                "INNER JOIN markets ON markets.id = brokers.market_id "
+                "INNER JOIN markettypes ON markets.market_type_id = markettypes.id"));
+        }
+
+        auto brokers = std::make_shared<BrokerMetadataMap>();
+        while (res->next()) {
+            BrokerMetadata& broker = (*brokers)[res->getInt("id")];
+            broker.fees.spred = res->getDouble("spred");
+            broker.fees.procent_comission = res->getDouble("procent_comission");
+            broker.fees.fix_comission = res->getDouble("fox_comission");
+            broker.market_type_name = res->getString("market_type_name");
+        }
+        return brokers;
+    }
+};
+
+#endif // BROKER_METADATA_CACHE_HPP
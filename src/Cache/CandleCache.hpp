@@ -0,0 +1,320 @@
+#ifndef CANDLE_CACHE_HPP
+#define CANDLE_CACHE_HPP
+
+#include "../Informers/Informer.hpp"
+#include "../Data/CandleSeries.hpp"
+#include "../Storage/CandleArchive.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "../struct.hpp"
+#include "../Utils/Logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// Счётчики кэша свечей
+struct CandleCacheStats {
+    uint64_t hits;            // запрос полностью обслужен из кэша
+    uint64_t partial_hits;    // догружены только недостающие участки
+    uint64_t misses;          // данных в кэше не было совсем
+    uint64_t fetched_candles; // свечей загружено из архива и информеров
+    uint64_t evictions;       // вытесненных рядов
+    size_t cached_candles;
+    size_t series;
+};
+
+// Общий для процесса кэш свечей по ключу (рынок, символ, интервал).
+// Ряд хранится непрерывными сегментами, выровненными по границам интервала;
+// из информера запрашиваются только отсутствующие участки.
+class CandleCache {
+public:
+    static CandleCache& getInstance() {
+        static CandleCache instance;
+        return instance;
+    }
+
+    // Упорядоченные по времени свечи периода [start_date, end_date] (секунды от эпохи)
+    CandleSeries get_symbol_historical(
+        const std::shared_ptr<Informer>& informer,
+        const std::string& symbol,
+        const std::string& start_date,
+        const std::string& end_date,
+        const std::string& interval
+    ) {
+        long long step = TimeUtils::interval_seconds(interval);
+        long long start = 0;
+        long long end = 0;
+        if (step == 0 || !parse_seconds(start_date, start) || !parse_seconds(end_date, end) || start > end) {
+            // Нестандартный запрос кэшировать не умеем - идём напрямую в информер
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            std::vector<CandleData> response;
+            {
+                ScopedTimer timer(Metrics::informer_latency(typeid(*informer), "get_symbol_historical"));
+                response = informer->get_symbol_historical(symbol, start_date, end_date, interval);
+            }
+            return CandleSeries::from_candles(response);
+        }
+        start = TimeUtils::align_down(start, step);
+
+        std::string key = make_key(*informer, symbol, interval);
+        std::shared_ptr<Series> series = acquire(key);
+
+        CandleSeries result;
+        long long added = 0;
+        {
+            std::lock_guard<std::mutex> lock(series->mutex);
+
+            // Последняя свеча, которая уже закрыта и больше не изменится
+            long long last_closed = TimeUtils::align_down(TimeUtils::now_seconds(), step) - step;
+
+            std::vector<Range> gaps = find_gaps(*series, start, end);
+            if (gaps.empty()) {
+                hits_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (gaps.size() == 1 && gaps[0].start == start && gaps[0].end == end) {
+                misses_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else {
+                partial_hits_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Незакрытые свечи хвоста отдаём, но не сохраняем
+            CandleSeries open_tail;
+            for (const auto& gap : gaps) {
+                // Сначала архив на диске, из информера - только то, чего в нём нет
+                CandleSeries fetched = CandleArchive::getInstance().get_symbol_historical(
+                    informer, symbol, gap.start, gap.end, interval);
+                fetched_candles_.fetch_add(fetched.size(), std::memory_order_relaxed);
+
+                size_t first = fetched.lower_bound(gap.start * 1000);
+                size_t split = fetched.lower_bound((last_closed + 1) * 1000);
+                size_t last = fetched.lower_bound((gap.end + 1) * 1000);
+                CandleSeries closed;
+                closed.append(fetched, first, std::min(split, last));
+                open_tail.append(fetched, std::max(first, split), last);
+
+                // Пустой ответ может означать ошибку сети, такой участок не запоминаем. Ответ может быть и урезан
+                // лимитом информера, поэтому сегмент - только от первой до последней полученной закрытой свечи
+                if (!closed.empty()) {
+                    long long covered_start = std::max(gap.start, TimeUtils::align_down(closed.timestamp(0) / 1000, step));
+                    long long covered_end = std::min({ gap.end, last_closed + step - 1,
+                        closed.timestamp(closed.size() - 1) / 1000 + step - 1 });
+                    added += insert_segment(*series, { covered_start, covered_end }, std::move(closed));
+                }
+            }
+
+            collect(*series, start, end, result);
+            if (!open_tail.empty()) {
+                result.append(open_tail);
+                result.sort();
+            }
+        }
+
+        if (added != 0) {
+            account(key, series, added);
+        }
+        return result;
+    }
+
+    CandleCacheStats get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {
+            hits_.load(std::memory_order_relaxed),
+            partial_hits_.load(std::memory_order_relaxed),
+            misses_.load(std::memory_order_relaxed),
+            fetched_candles_.load(std::memory_order_relaxed),
+            evictions_.load(std::memory_order_relaxed),
+            total_candles_,
+            series_.size()
+        };
+    }
+
+    void set_capacity(size_t max_candles) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_candles_ = max_candles;
+        evict_locked("");
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        series_.clear();
+        lru_.clear();
+        total_candles_ = 0;
+    }
+
+private:
+    // Диапазон времени в секундах, границы включительно
+    struct Range {
+        long long start;
+        long long end;
+    };
+
+    // Непрерывный участок ряда: все свечи с временем открытия в [start, end]
+    struct Segment {
+        Range range;
+        CandleSeries candles;
+    };
+
+    struct Series {
+        std::mutex mutex;
+        std::map<long long, Segment> segments; // ключ - начало сегмента
+        std::atomic<size_t> candle_count{ 0 }; // читается при вытеснении без блокировки ряда
+        std::list<std::string>::iterator lru_it;
+    };
+
+    static constexpr size_t default_capacity = 1000000;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Series>> series_;
+    std::list<std::string> lru_; // в начале - самые свежие ряды
+    size_t total_candles_ = 0;
+    size_t max_candles_ = default_capacity;
+
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> partial_hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+    std::atomic<uint64_t> fetched_candles_{ 0 };
+    std::atomic<uint64_t> evictions_{ 0 };
+
+    CandleCache() {
+        const char* value = std::getenv("TRADESNAKE_CANDLE_CACHE_SIZE");
+        if (value != nullptr) {
+            try {
+                max_candles_ = static_cast<size_t>(std::stoull(value));
+            }
+            catch (const std::exception&) {
+                log_warn() << "Invalid value of TRADESNAKE_CANDLE_CACHE_SIZE: " << value;
+            }
+        }
+    }
+
+    CandleCache(const CandleCache&) = delete;
+    CandleCache& operator=(const CandleCache&) = delete;
+
+    static bool parse_seconds(const std::string& value, long long& seconds) {
+        try {
+            size_t pos = 0;
+            seconds = std::stoll(value, &pos);
+            return pos == value.size();
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // Рынок определяется типом информера (ByBit, Tinkoff, Yahoo)
+    static std::string make_key(const Informer& informer, const std::string& symbol, const std::string& interval) {
+        return std::string(typeid(informer).name()) + "|" + symbol + "|" + interval;
+    }
+
+    std::shared_ptr<Series> acquire(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = series_.find(key);
+        if (it != series_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second->lru_it);
+            return it->second;
+        }
+        auto series = std::make_shared<Series>();
+        lru_.push_front(key);
+        series->lru_it = lru_.begin();
+        series_[key] = series;
+        return series;
+    }
+
+    static std::vector<Range> find_gaps(const Series& series, long long start, long long end) {
+        std::vector<Range> gaps;
+        long long cursor = start;
+        auto it = series.segments.upper_bound(start);
+        if (it != series.segments.begin()) --it;
+        for (; it != series.segments.end() && it->second.range.start <= end; ++it) {
+            const Range& range = it->second.range;
+            if (range.end < cursor) continue;
+            if (range.start > cursor) {
+                gaps.push_back({ cursor, range.start - 1 });
+            }
+            cursor = range.end + 1;
+            if (cursor > end) break;
+        }
+        if (cursor <= end) {
+            gaps.push_back({ cursor, end });
+        }
+        return gaps;
+    }
+
+    // Добавляет сегмент и склеивает его с соседними; возвращает прирост числа свечей
+    static long long insert_segment(Series& series, Range range, CandleSeries candles) {
+        size_t before = series.candle_count.load();
+        Segment merged{ range, std::move(candles) };
+
+        auto it = series.segments.upper_bound(range.start);
+        if (it != series.segments.begin()) --it;
+        while (it != series.segments.end() && it->second.range.start <= merged.range.end + 1) {
+            if (it->second.range.end + 1 < merged.range.start) {
+                ++it;
+                continue;
+            }
+            Segment& other = it->second;
+            CandleSeries joined = CandleSeries::merge(other.candles, merged.candles);
+
+            merged.range.start = std::min(merged.range.start, other.range.start);
+            merged.range.end = std::max(merged.range.end, other.range.end);
+            merged.candles = std::move(joined);
+            series.candle_count -= other.candles.size();
+            it = series.segments.erase(it);
+        }
+        series.candle_count += merged.candles.size();
+        series.segments[merged.range.start] = std::move(merged);
+        return static_cast<long long>(series.candle_count.load()) - static_cast<long long>(before);
+    }
+
+    // Свечи с временем открытия в [start, end] секунд; сегменты не пересекаются, поэтому порядок сохраняется
+    static void collect(const Series& series, long long start, long long end, CandleSeries& out) {
+        auto it = series.segments.upper_bound(start);
+        if (it != series.segments.begin()) --it;
+        for (; it != series.segments.end() && it->second.range.start <= end; ++it) {
+            const CandleSeries& candles = it->second.candles;
+            out.append(candles, candles.lower_bound(start * 1000), candles.lower_bound((end + 1) * 1000));
+        }
+    }
+
+    // Учитывает новые свечи и вытесняет давно не использованные ряды
+    void account(const std::string& key, const std::shared_ptr<Series>& series, long long added) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = series_.find(key);
+        if (it == series_.end() || it->second != series) {
+            return; // ряд вытеснили, пока шла загрузка
+        }
+        total_candles_ = static_cast<size_t>(std::max<long long>(0, static_cast<long long>(total_candles_) + added));
+        evict_locked(key);
+    }
+
+    void evict_locked(const std::string& keep) {
+        while (total_candles_ > max_candles_ && !lru_.empty()) {
+            const std::string& victim = lru_.back();
+            if (victim == keep) {
+                if (lru_.size() == 1) break;
+                lru_.splice(lru_.begin(), lru_, std::prev(lru_.end()));
+                continue;
+            }
+            auto it = series_.find(victim);
+            if (it != series_.end()) {
+                total_candles_ -= std::min(total_candles_, it->second->candle_count.load());
+                series_.erase(it);
+            }
+            lru_.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+#endif // CANDLE_CACHE_HPP
@@ -0,0 +1,185 @@
+#ifndef CANDLE_SERIES_HPP
+#define CANDLE_SERIES_HPP
+
+#include "../struct.hpp"
+#include "../Utils/AlignedAllocator.hpp"
+#include "../Utils/Span.hpp"
+#include "../Utils/Logger.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// Ряд свечей по столбцам: время открытия (мс от эпохи) и цены/объёмы в отдельных выровненных массивах.
+// Свечи упорядочены по времени; столбцы отдаются наружу как Span без копирования.
+class CandleSeries {
+public:
+    using TimeColumn = std::vector<int64_t, AlignedAllocator<int64_t>>;
+    using ValueColumn = std::vector<double, AlignedAllocator<double>>;
+
+    CandleSeries() = default;
+
+    // Разбор ответа информера; свечи с нечисловым временем пропускаются
+    static CandleSeries from_candles(const std::vector<CandleData>& candles) {
+        CandleSeries series;
+        series.reserve(candles.size());
+        for (const auto& candle : candles) {
+            try {
+                series.push_back(std::stoll(candle.timestamp), candle.open, candle.high, candle.low,
+                    candle.close, candle.volume, candle.turnover);
+            }
+            catch (const std::exception&) {
+                log_warn() << "Skipping candle with invalid timestamp: " << candle.timestamp;
+            }
+        }
+        series.sort();
+        return series;
+    }
+
+    size_t size() const { return timestamps_.size(); }
+    bool empty() const { return timestamps_.empty(); }
+
+    void reserve(size_t count) {
+        timestamps_.reserve(count);
+        open_.reserve(count);
+        high_.reserve(count);
+        low_.reserve(count);
+        close_.reserve(count);
+        volume_.reserve(count);
+        turnover_.reserve(count);
+    }
+
+    void clear() {
+        timestamps_.clear();
+        open_.clear();
+        high_.clear();
+        low_.clear();
+        close_.clear();
+        volume_.clear();
+        turnover_.clear();
+    }
+
+    void push_back(int64_t timestamp, double open, double high, double low, double close, double volume, double turnover) {
+        timestamps_.push_back(timestamp);
+        open_.push_back(open);
+        high_.push_back(high);
+        low_.push_back(low);
+        close_.push_back(close);
+        volume_.push_back(volume);
+        turnover_.push_back(turnover);
+    }
+
+    // Добавляет свечи other с номерами [first, last)
+    void append(const CandleSeries& other, size_t first, size_t last) {
+        last = std::min(last, other.size());
+        if (first >= last) return;
+        append_column(timestamps_, other.timestamps_, first, last);
+        append_column(open_, other.open_, first, last);
+        append_column(high_, other.high_, first, last);
+        append_column(low_, other.low_, first, last);
+        append_column(close_, other.close_, first, last);
+        append_column(volume_, other.volume_, first, last);
+        append_column(turnover_, other.turnover_, first, last);
+    }
+
+    void append(const CandleSeries& other) { append(other, 0, other.size()); }
+
+    // Добавляет свечи из внешних столбцов одинаковой длины (например, отображённых в память)
+    void append(Span<const int64_t> timestamps, Span<const double> open, Span<const double> high,
+        Span<const double> low, Span<const double> close, Span<const double> volume, Span<const double> turnover) {
+        timestamps_.insert(timestamps_.end(), timestamps.begin(), timestamps.end());
+        open_.insert(open_.end(), open.begin(), open.end());
+        high_.insert(high_.end(), high.begin(), high.end());
+        low_.insert(low_.end(), low.begin(), low.end());
+        close_.insert(close_.end(), close.begin(), close.end());
+        volume_.insert(volume_.end(), volume.begin(), volume.end());
+        turnover_.insert(turnover_.end(), turnover.begin(), turnover.end());
+    }
+
+    Span<const int64_t> timestamps() const { return { timestamps_.data(), timestamps_.size() }; }
+    Span<const double> open() const { return { open_.data(), open_.size() }; }
+    Span<const double> high() const { return { high_.data(), high_.size() }; }
+    Span<const double> low() const { return { low_.data(), low_.size() }; }
+    Span<const double> close() const { return { close_.data(), close_.size() }; }
+    Span<const double> volume() const { return { volume_.data(), volume_.size() }; }
+    Span<const double> turnover() const { return { turnover_.data(), turnover_.size() }; }
+
+    int64_t timestamp(size_t index) const { return timestamps_[index]; }
+
+    // Свеча в старом построчном виде (для информеров и внешних API)
+    CandleData candle(size_t index) const {
+        return { std::to_string(timestamps_[index]), open_[index], close_[index], high_[index],
+            low_[index], volume_[index], turnover_[index] };
+    }
+
+    // Номер первой свечи со временем не меньше timestamp_ms
+    size_t lower_bound(int64_t timestamp_ms) const {
+        return std::lower_bound(timestamps_.begin(), timestamps_.end(), timestamp_ms) - timestamps_.begin();
+    }
+
+    bool is_sorted() const {
+        return std::is_sorted(timestamps_.begin(), timestamps_.end());
+    }
+
+    // Упорядочивает по времени и убирает повторы (остаётся первая свеча с данным временем)
+    void sort() {
+        if (std::adjacent_find(timestamps_.begin(), timestamps_.end(),
+            [](int64_t a, int64_t b) { return a >= b; }) == timestamps_.end()) {
+            return; // информеры почти всегда отдают уже упорядоченные свечи
+        }
+        std::vector<size_t> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return timestamps_[a] < timestamps_[b];
+            });
+        order.erase(std::unique(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return timestamps_[a] == timestamps_[b];
+            }), order.end());
+
+        CandleSeries sorted;
+        sorted.reserve(order.size());
+        for (size_t index : order) {
+            sorted.push_back(timestamps_[index], open_[index], high_[index], low_[index],
+                close_[index], volume_[index], turnover_[index]);
+        }
+        *this = std::move(sorted);
+    }
+
+    // Слияние двух упорядоченных рядов; при совпадении времени берётся свеча из first
+    static CandleSeries merge(const CandleSeries& first, const CandleSeries& second) {
+        CandleSeries result;
+        result.reserve(first.size() + second.size());
+        size_t i = 0;
+        size_t j = 0;
+        while (i < first.size() || j < second.size()) {
+            size_t from_first = i;
+            while (i < first.size() && (j == second.size() || first.timestamps_[i] <= second.timestamps_[j])) {
+                if (j < second.size() && first.timestamps_[i] == second.timestamps_[j]) ++j;
+                ++i;
+            }
+            result.append(first, from_first, i);
+            size_t from_second = j;
+            while (j < second.size() && (i == first.size() || second.timestamps_[j] < first.timestamps_[i])) ++j;
+            result.append(second, from_second, j);
+        }
+        return result;
+    }
+
+private:
+    TimeColumn timestamps_;
+    ValueColumn open_;
+    ValueColumn high_;
+    ValueColumn low_;
+    ValueColumn close_;
+    ValueColumn volume_;
+    ValueColumn turnover_;
+
+    template <typename Column>
+    static void append_column(Column& to, const Column& from, size_t first, size_t last) {
+        to.insert(to.end(), from.begin() + first, from.begin() + last);
+    }
+};
+
+#endif // CANDLE_SERIES_HPP
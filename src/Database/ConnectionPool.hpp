@@ -0,0 +1,285 @@
+#ifndef CONNECTION_POOL_HPP
+#define CONNECTION_POOL_HPP
+
+#include "../const.hpp"
+#include "../Utils/Logger.hpp"
+#include <mysql/jdbc.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+class ConnectionPool;
+
+// Соединение пула вместе с кэшем подготовленных на нём запросов
+struct PooledConnectionEntry {
+    static constexpr size_t max_statements = 64;
+
+    std::shared_ptr<sql::Connection> connection;
+    std::unordered_map<std::string, std::shared_ptr<sql::PreparedStatement>> statements;
+};
+
+// Соединение, взятое из пула; возвращается в пул при разрушении.
+// Если объект разрушается из-за исключения, соединение перед следующей выдачей проверяется
+class PooledConnection {
+public:
+    PooledConnection() = default;
+    PooledConnection(ConnectionPool* pool, std::shared_ptr<PooledConnectionEntry> entry)
+        : pool_(pool), connection_(std::move(entry)) {
+    }
+    PooledConnection(PooledConnection&& other) noexcept
+        : pool_(other.pool_), connection_(std::move(other.connection_)), broken_(other.broken_), uncaught_(other.uncaught_) {
+        other.pool_ = nullptr;
+    }
+    PooledConnection& operator=(PooledConnection&& other) noexcept {
+        if (this != &other) {
+            release();
+            pool_ = other.pool_;
+            connection_ = std::move(other.connection_);
+            broken_ = other.broken_;
+            uncaught_ = other.uncaught_;
+            other.pool_ = nullptr;
+        }
+        return *this;
+    }
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+    ~PooledConnection() { release(); }
+
+    sql::Connection* operator->() const { return connection_->connection.get(); }
+    sql::Connection& operator*() const { return *connection_->connection; }
+    sql::Connection* get() const { return connection_ ? connection_->connection.get() : nullptr; }
+    explicit operator bool() const { return static_cast<bool>(connection_); }
+
+    // Подготовленный запрос из кэша соединения: повторно не компилируется на сервере
+    std::shared_ptr<sql::PreparedStatement> prepare(const std::string& query) {
+        auto& statements = connection_->statements;
+        auto it = statements.find(query);
+        if (it != statements.end()) {
+            it->second->clearParameters();
+            return it->second;
+        }
+        if (statements.size() >= PooledConnectionEntry::max_statements) {
+            statements.erase(statements.begin());
+        }
+        std::shared_ptr<sql::PreparedStatement> statement(connection_->connection->prepareStatement(query));
+        statements[query] = statement;
+        return statement;
+    }
+
+    // Соединение не вернётся в пул, а будет закрыто (например, после обрыва)
+    void invalidate() { broken_ = true; }
+
+    // Для перехваченной ошибки запроса: при обрыве связи соединение в пул не возвращается
+    void on_error(const sql::SQLException& e) {
+        if (is_connection_error(e)) invalidate();
+    }
+
+    // 2006 - сервер недоступен, 2013 и 2055 - связь потеряна во время запроса
+    static bool is_connection_error(const sql::SQLException& e) {
+        return e.getErrorCode() == 2006 || e.getErrorCode() == 2013 || e.getErrorCode() == 2055;
+    }
+
+    inline void release();
+
+private:
+    ConnectionPool* pool_ = nullptr;
+    std::shared_ptr<PooledConnectionEntry> connection_;
+    bool broken_ = false;
+    int uncaught_ = std::uncaught_exceptions(); // исключений в полёте при взятии соединения
+};
+
+// Счётчики пула соединений
+struct ConnectionPoolStats {
+    size_t max_size;
+    size_t open;              // всего открытых соединений
+    size_t idle;
+    size_t in_use;
+    uint64_t acquired;
+    uint64_t waited;          // сколько раз пришлось ждать свободное соединение
+    uint64_t wait_time_us;    // суммарное время ожидания
+    uint64_t exhausted;       // ожидание закончилось таймаутом
+    uint64_t created;
+    uint64_t reconnects;      // соединение оборвалось или не прошло проверку и было заменено
+};
+
+// Ограниченный потокобезопасный пул соединений MySQL, общий для Broker, TradeBot и BotHandler
+class ConnectionPool {
+public:
+    static ConnectionPool& getInstance() {
+        static ConnectionPool instance;
+        return instance;
+    }
+
+    // Берёт соединение; при исчерпании пула ждёт не дольше timeout, затем бросает исключение
+    PooledConnection acquire(std::chrono::milliseconds timeout = std::chrono::milliseconds(5000)) {
+        auto started = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> lock(mutex_);
+        acquired_.fetch_add(1, std::memory_order_relaxed);
+
+        if (idle_.empty() && open_ >= max_size_) {
+            waited_.fetch_add(1, std::memory_order_relaxed);
+            bool ready = available_.wait_for(lock, timeout, [this]() {
+                return !idle_.empty() || open_ < max_size_;
+                });
+            wait_time_us_.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started).count(), std::memory_order_relaxed);
+            if (!ready) {
+                exhausted_.fetch_add(1, std::memory_order_relaxed);
+                throw std::runtime_error("MySQL connection pool exhausted");
+            }
+        }
+
+        if (!idle_.empty()) {
+            IdleConnection idle = std::move(idle_.back());
+            idle_.pop_back();
+            ++in_use_;
+            lock.unlock();
+            return PooledConnection(this, check_health(std::move(idle)));
+        }
+
+        // Резервируем место и открываем соединение без блокировки пула
+        ++open_;
+        ++in_use_;
+        lock.unlock();
+        try {
+            return PooledConnection(this, open_connection());
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> relock(mutex_);
+            --open_;
+            --in_use_;
+            available_.notify_one();
+            throw;
+        }
+    }
+
+    ConnectionPoolStats get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {
+            max_size_,
+            open_,
+            idle_.size(),
+            in_use_,
+            acquired_.load(std::memory_order_relaxed),
+            waited_.load(std::memory_order_relaxed),
+            wait_time_us_.load(std::memory_order_relaxed),
+            exhausted_.load(std::memory_order_relaxed),
+            created_.load(std::memory_order_relaxed),
+            reconnects_.load(std::memory_order_relaxed)
+        };
+    }
+
+private:
+    friend class PooledConnection;
+
+    struct IdleConnection {
+        std::shared_ptr<PooledConnectionEntry> connection;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    static constexpr size_t default_size = 16;
+    // Соединение, простоявшее дольше, проверяется перед выдачей
+    static constexpr std::chrono::seconds validate_after{ 30 };
+
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<IdleConnection> idle_;
+    size_t open_ = 0;
+    size_t in_use_ = 0;
+    size_t max_size_ = default_size;
+
+    std::atomic<uint64_t> acquired_{ 0 };
+    std::atomic<uint64_t> waited_{ 0 };
+    std::atomic<uint64_t> wait_time_us_{ 0 };
+    std::atomic<uint64_t> exhausted_{ 0 };
+    std::atomic<uint64_t> created_{ 0 };
+    std::atomic<uint64_t> reconnects_{ 0 };
+
+    ConnectionPool() {
+        const char* value = std::getenv("TRADESNAKE_DB_POOL_SIZE");
+        if (value != nullptr) {
+            try {
+                max_size_ = std::max<size_t>(1, std::stoul(value));
+            }
+            catch (const std::exception&) {
+                log_warn() << "Invalid value of TRADESNAKE_DB_POOL_SIZE: " << value;
+            }
+        }
+    }
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    std::shared_ptr<PooledConnectionEntry> open_connection() {
+        auto entry = std::make_shared<PooledConnectionEntry>();
+        entry->connection = Constants::createConnection();
+        if (!entry->connection) {
+            throw std::runtime_error("Failed to open MySQL connection");
+        }
+        created_.fetch_add(1, std::memory_order_relaxed);
+        return entry;
+    }
+
+    std::shared_ptr<PooledConnectionEntry> check_health(IdleConnection idle) {
+        if (std::chrono::steady_clock::now() - idle.since < validate_after) {
+            return std::move(idle.connection);
+        }
+        try {
+            if (!idle.connection->connection->isClosed() && idle.connection->connection->isValid()) {
+                return std::move(idle.connection);
+            }
+        }
+        catch (const sql::SQLException& e) {
+            log_error() << "MySQL connection check failed: " << e.what();
+        }
+        // Соединение оборвалось - открываем новое на его месте
+        reconnects_.fetch_add(1, std::memory_order_relaxed);
+        try {
+            return open_connection();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --open_;
+            --in_use_;
+            available_.notify_one();
+            throw;
+        }
+    }
+
+    // suspect - соединение возвращается во время исключения: проверим его при следующей выдаче
+    void release(std::shared_ptr<PooledConnectionEntry> connection, bool broken, bool suspect) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --in_use_;
+            if (broken || !connection) {
+                --open_;
+                if (broken) reconnects_.fetch_add(1, std::memory_order_relaxed);
+            }
+            else {
+                auto since = suspect ? std::chrono::steady_clock::time_point() : std::chrono::steady_clock::now();
+                idle_.push_back({ std::move(connection), since });
+            }
+        }
+        available_.notify_one();
+    }
+};
+
+inline void PooledConnection::release() {
+    if (pool_ != nullptr) {
+        pool_->release(std::move(connection_), broken_, std::uncaught_exceptions() > uncaught_);
+        pool_ = nullptr;
+    }
+}
+
+#endif // CONNECTION_POOL_HPP
@@ -10,110 +10,172 @@
 #include <iostream>
 #include <algorithm>
 #include "../struct.hpp"
+#include "../Cache/CandleCache.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "./StreamingIndicators.hpp"
+#include "./SimdKernels.hpp"
+#include "../Utils/Logger.hpp"
+#include <functional>
+#include <map>
+#include <string>
 
 class IndicatorsCalc {
 private:
-    std::shared_ptr<Informer> informer;
+    // Сколько свечей сверх длины индикатора подгружать при засеве
+    static constexpr int warmup_candles = 500;
 
-    std::string get_past_timestamp(const std::string& interval, int periods, std::string end_date) {
-        long long end_time = std::stoll(end_date);
-        int interval_seconds = 0;
+    // Состояние потокового индикатора для одного (символ, длина, интервал)
+    struct IndicatorStream {
+        std::unique_ptr<StreamingIndicator> indicator;
+        long long last_timestamp = -1; // время последней учтённой закрытой свечи, мс
+    };
 
-        if (interval == "1") interval_seconds = 60;
-        else if (interval == "5") interval_seconds = 5 * 60;
-        else if (interval == "15") interval_seconds = 15 * 60;
-        else if (interval == "60") interval_seconds = 60 * 60;
-        else if (interval == "d") interval_seconds = 24 * 60 * 60;
-        else {
-            std::cerr << "Unsupported interval: " << interval << std::endl;
-            return "";
-        }
+    // Ряд индикатора, посчитанный векторными ядрами на весь период бэктеста
+    struct PrecomputedSeries {
+        std::vector<int64_t> timestamps; // время открытия свечей, мс
+        SimdKernels::IndicatorSeries values;
+    };
 
-        long long start_time = end_time - periods * interval_seconds;
-        return std::to_string(start_time);
-    }
+    using BatchKernel = std::function<SimdKernels::IndicatorSeries(Span<const double>)>;
 
-    std::vector<double> extract_close_prices(const std::vector<CandleData>& candles) {
-        std::vector<double> close_prices;
-        close_prices.reserve(candles.size());
-        for (const auto& candle : candles) {
-            close_prices.push_back(candle.close);
+    std::shared_ptr<Informer> informer;
+    std::map<std::string, IndicatorStream> streams;
+
+    bool backtest = false;
+    long long backtest_start = 0; // границы периода бэктеста, секунды
+    long long backtest_end = 0;
+    std::map<std::string, PrecomputedSeries> precomputed;
+
+    // Обновляет индикатор свечами до end_date и возвращает его значение.
+    // Первый вызов засевает индикатор историей, последующие догружают только новые свечи.
+    double stream_value(const std::string& key, const std::function<std::unique_ptr<StreamingIndicator>()>& factory,
+        const std::string& symbol, int length, const std::string& interval, const std::string& end_date,
+        const char* name, double fallback) {
+        long long step = TimeUtils::interval_seconds(interval);
+        if (step == 0) {
+            log_warn().symbol(symbol) << "Unsupported interval: " << interval;
+            return fallback;
         }
-        return close_prices;
-    }
+        long long end_time = std::stoll(end_date);
 
-    std::vector<double> calculate_price_changes(const std::vector<double>& prices) {
-        std::vector<double> changes;
-        for (size_t i = 1; i < prices.size(); ++i) {
-            changes.push_back(prices[i] - prices[i - 1]);
+        IndicatorStream& stream = streams[key];
+        if (!stream.indicator) {
+            stream.indicator = factory();
         }
-        return changes;
-    }
 
-public:
-    explicit IndicatorsCalc(std::shared_ptr<Informer> informer) : informer(informer) {}
-
-    double calculate_ma(const std::string& symbol, int ma_length, const std::string& interval, std::string end_date) {
-        std::string start_date = get_past_timestamp(interval, ma_length+500, end_date);
-        std::vector<CandleData> candles = informer->get_symbol_historical(symbol, start_date, end_date, interval);
-        std::vector<double> close_prices = extract_close_prices(candles);
-
-        if (close_prices.size() < ma_length) {
-            std::cerr << "    MA" << std::endl;
-            return 0.0;
+        long long window = static_cast<long long>(length + warmup_candles) * step;
+        long long start_time;
+        if (stream.last_timestamp < 0 || end_time * 1000 < stream.last_timestamp ||
+            end_time - stream.last_timestamp / 1000 > window) {
+            // Нет состояния, время пошло назад или пропуск слишком большой - засеваем заново
+            stream.indicator->reset();
+            stream.last_timestamp = -1;
+            start_time = end_time - window;
         }
-        if (close_prices.size() > static_cast<size_t>(ma_length)) {
-            close_prices.erase(close_prices.begin(), close_prices.end() - (ma_length));
+        else {
+            start_time = stream.last_timestamp / 1000 + step;
         }
 
-        return std::accumulate(close_prices.end() - ma_length, close_prices.end(), 0.0) / ma_length;
-    }
+        // Незакрытую свечу учитываем в значении, но не в состоянии
+        long long open_candle = TimeUtils::align_down(TimeUtils::now_seconds(), step);
+        bool has_pending = false;
+        double pending_close = 0.0;
+
+        if (start_time <= end_time) {
+            CandleSeries candles = CandleCache::getInstance().get_symbol_historical(
+                informer, symbol, std::to_string(start_time), end_date, interval);
+            Span<const int64_t> timestamps = candles.timestamps();
+            Span<const double> closes = candles.close();
+            for (size_t i = candles.lower_bound(stream.last_timestamp + 1); i < candles.size(); ++i) {
+                if (timestamps[i] / 1000 >= open_candle) {
+                    has_pending = true;
+                    pending_close = closes[i];
+                    continue;
+                }
+                stream.indicator->update(closes[i]);
+                stream.last_timestamp = timestamps[i];
+            }
+        }
 
-    double calculate_rsi(const std::string& symbol, int rsi_period, const std::string& interval, std::string end_date) {
-        std::string start_date = get_past_timestamp(interval, rsi_period + 500, end_date);
-        std::vector<CandleData> candles = informer->get_symbol_historical(symbol, start_date, end_date, interval);
+        if (!stream.indicator->is_ready(has_pending)) {
+            log_warn().symbol(symbol) << "Недостаточно данных для расчета " << name;
+            return fallback;
+        }
+        return has_pending ? stream.indicator->preview(pending_close) : stream.indicator->value();
+    }
 
-        if (candles.size() <= static_cast<size_t>(rsi_period)) {
-            std::cerr << "    RSI" << std::endl;
-            return 50.0;
+    // Значение из ряда, посчитанного целиком при первом обращении; время вне периода бэктеста - через поток
+    double indicator_value(const std::string& key, const std::function<std::unique_ptr<StreamingIndicator>()>& factory,
+        const BatchKernel& batch, const std::string& symbol, int length, const std::string& interval,
+        const std::string& end_date, const char* name, double fallback) {
+        long long step = TimeUtils::interval_seconds(interval);
+        long long end_time = std::stoll(end_date);
+        if (!backtest || step == 0 || end_time < backtest_start || end_time > backtest_end) {
+            return stream_value(key, factory, symbol, length, interval, end_date, name, fallback);
         }
 
-        std::vector<double> close_prices = extract_close_prices(candles);
-        std::vector<double> changes = calculate_price_changes(close_prices);
+        auto it = precomputed.find(key);
+        if (it == precomputed.end()) {
+            // Тот же разгон, что и при засеве потокового индикатора от первой свечи бэктеста
+            long long window = static_cast<long long>(length + warmup_candles) * step;
+            CandleSeries candles = CandleCache::getInstance().get_symbol_historical(
+                informer, symbol, std::to_string(backtest_start - window), std::to_string(backtest_end), interval);
+            PrecomputedSeries series;
+            series.timestamps.assign(candles.timestamps().begin(), candles.timestamps().end());
+            series.values = batch(candles.close());
+            it = precomputed.emplace(key, std::move(series)).first;
+        }
 
-        //     
-        if (changes.size() > static_cast<size_t>(rsi_period + 1)) {
-            changes.erase(changes.begin(), changes.end() - (rsi_period + 1));
+        // Последняя свеча с временем открытия не позже end_date
+        const PrecomputedSeries& series = it->second;
+        size_t count = std::lower_bound(series.timestamps.begin(), series.timestamps.end(), (end_time + 1) * 1000)
+            - series.timestamps.begin();
+        if (count == 0 || std::isnan(series.values[count - 1])) {
+            log_warn().symbol(symbol) << "Недостаточно данных для расчета " << name;
+            return fallback;
         }
+        return series.values[count - 1];
+    }
 
-        double avg_gain = 0.0;
-        double avg_loss = 0.0;
+    static std::string stream_key(const char* name, const std::string& symbol, int length, const std::string& interval) {
+        return std::string(name) + "|" + symbol + "|" + std::to_string(length) + "|" + interval;
+    }
 
-        //    gain/loss
-        for (int i = 0; i < rsi_period; ++i) {
-            if (changes[i] > 0) avg_gain += changes[i];
-            else avg_loss += std::abs(changes[i]);
-        }
+public:
+    explicit IndicatorsCalc(std::shared_ptr<Informer> informer) : informer(informer) {}
 
-        avg_gain /= rsi_period;
-        avg_loss /= rsi_period;
+    // Бэктест по периоду [start_seconds, end_seconds]: индикаторы считаются по всему ряду сразу
+    void begin_backtest(long long start_seconds, long long end_seconds) {
+        backtest = true;
+        backtest_start = start_seconds;
+        backtest_end = end_seconds;
+        precomputed.clear();
+    }
 
-        //  RSI    (  rsi_period,    rsi_period   )
-        for (size_t i = rsi_period; i < changes.size(); ++i) {
-            double current_change = changes[i];
-            double gain = 0.0, loss = 0.0;
+    void end_backtest() {
+        backtest = false;
+        precomputed.clear();
+    }
 
-            if (current_change > 0) gain = current_change;
-            else loss = std::abs(current_change);
+    double calculate_ma(const std::string& symbol, int ma_length, const std::string& interval, std::string end_date) {
+        return indicator_value(stream_key("MA", symbol, ma_length, interval),
+            [ma_length]() { return std::make_unique<SmaIndicator>(ma_length); },
+            [ma_length](Span<const double> closes) { return SimdKernels::sma(closes, ma_length); },
+            symbol, ma_length, interval, end_date, "MA", 0.0);
+    }
 
-            //   
-            avg_gain = (avg_gain * (rsi_period - 1) + gain) / rsi_period;
-            avg_loss = (avg_loss * (rsi_period - 1) + loss) / rsi_period;
-        }
+    double calculate_ema(const std::string& symbol, int ema_length, const std::string& interval, std::string end_date) {
+        return indicator_value(stream_key("EMA", symbol, ema_length, interval),
+            [ema_length]() { return std::make_unique<EmaIndicator>(ema_length); },
+            [ema_length](Span<const double> closes) { return SimdKernels::ema(closes, ema_length); },
+            symbol, ema_length, interval, end_date, "EMA", 0.0);
+    }
 
-        if (avg_loss == 0.0) return 100.0;
-        double rs = avg_gain / avg_loss;
-        return 100.0 - (100.0 / (1.0 + rs));
+    double calculate_rsi(const std::string& symbol, int rsi_period, const std::string& interval, std::string end_date) {
+        return indicator_value(stream_key("RSI", symbol, rsi_period, interval),
+            [rsi_period]() { return std::make_unique<RsiIndicator>(rsi_period); },
+            [rsi_period](Span<const double> closes) { return SimdKernels::rsi(closes, rsi_period); },
+            symbol, rsi_period, interval, end_date, "RSI", 50.0);
     }
 };
 
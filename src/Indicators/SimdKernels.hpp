@@ -0,0 +1,548 @@
+#ifndef SIMD_KERNELS_HPP
+#define SIMD_KERNELS_HPP
+
+#include "../Utils/AlignedAllocator.hpp"
+#include "../Utils/Span.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#else
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#endif
+#endif
+
+// Векторные ядра индикаторов по целому ряду цен (AVX-512 / AVX2 / скалярный вариант, выбор при запуске).
+// Независимые по элементам части (разности окон, доходности, прирост/падение, агрегаты) считаются векторно,
+// рекуррентные (накопление сумм, EMA, сглаживание Уайлдера) - одним скалярным проходом по готовым разностям.
+// Не готовые значения (окно ещё не заполнено) равны NaN.
+namespace SimdKernels {
+
+    using IndicatorSeries = std::vector<double, AlignedAllocator<double>>;
+
+    enum class Level { Scalar = 0, Avx2 = 1, Avx512 = 2 };
+
+    // Агрегаты ряда за один проход
+    struct SeriesStats {
+        size_t count;
+        double min;
+        double max;
+        double mean;
+        double variance; // дисперсия генеральной совокупности
+    };
+
+    inline const char* level_name(Level level) {
+        switch (level) {
+        case Level::Avx512: return "avx512";
+        case Level::Avx2: return "avx2";
+        default: return "scalar";
+        }
+    }
+
+    // Что поддерживают процессор и ОС
+    inline Level detect_level() {
+#if defined(SIMD_KERNELS_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return Level::Scalar;
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave) return Level::Scalar;
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        bool avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+        if (avx512) return Level::Avx512;
+        if (avx2) return Level::Avx2;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return Level::Avx512;
+        if (__builtin_cpu_supports("avx2")) return Level::Avx2;
+#endif
+#endif
+        return Level::Scalar;
+    }
+
+    namespace detail {
+        // Выбранный уровень; TRADESNAKE_SIMD=scalar|avx2|avx512 может только понизить его
+        inline std::atomic<int>& active() {
+            static std::atomic<int> level([]() {
+                Level supported = detect_level();
+                const char* value = std::getenv("TRADESNAKE_SIMD");
+                if (value != nullptr) {
+                    Level wanted = supported;
+                    if (std::strcmp(value, "scalar") == 0) wanted = Level::Scalar;
+                    else if (std::strcmp(value, "avx2") == 0) wanted = Level::Avx2;
+                    else if (std::strcmp(value, "avx512") == 0) wanted = Level::Avx512;
+                    return static_cast<int>(std::min(wanted, supported));
+                }
+                return static_cast<int>(supported);
+                }());
+            return level;
+        }
+
+        struct Sums {
+            double min;
+            double max;
+            double sum;     // сумма (x - shift)
+            double sum_sq;  // сумма (x - shift)^2
+        };
+
+        // ---------- скалярные варианты ----------
+
+        inline void sums_scalar(const double* x, size_t begin, size_t n, double shift, Sums& acc) {
+            for (size_t i = begin; i < n; ++i) {
+                acc.min = std::min(acc.min, x[i]);
+                acc.max = std::max(acc.max, x[i]);
+                double d = x[i] - shift;
+                acc.sum += d;
+                acc.sum_sq += d * d;
+            }
+        }
+
+        // out[i] = x[i] - x[i - lag] для i из [begin, n)
+        inline void lag_diff_scalar(const double* x, size_t begin, size_t n, size_t lag, double* out) {
+            for (size_t i = begin; i < n; ++i) out[i] = x[i] - x[i - lag];
+        }
+
+        // out[i] = (x[i] - shift)^2 - (x[i - lag] - shift)^2
+        inline void lag_diff_sq_scalar(const double* x, size_t begin, size_t n, size_t lag, double shift, double* out) {
+            for (size_t i = begin; i < n; ++i) {
+                double a = x[i] - shift;
+                double b = x[i - lag] - shift;
+                out[i] = a * a - b * b;
+            }
+        }
+
+        // out[i] = x[i + 1] / x[i] - 1
+        inline void returns_scalar(const double* x, size_t begin, size_t n, double* out) {
+            for (size_t i = begin; i + 1 < n; ++i) out[i] = x[i + 1] / x[i] - 1.0;
+        }
+
+        // gains[i] / losses[i] - рост и падение цены от свечи i к свече i + 1
+        inline void gains_losses_scalar(const double* x, size_t begin, size_t n, double* gains, double* losses) {
+            for (size_t i = begin; i + 1 < n; ++i) {
+                double change = x[i + 1] - x[i];
+                gains[i] = change > 0 ? change : 0.0;
+                losses[i] = change < 0 ? -change : 0.0;
+            }
+        }
+
+        inline void scale_scalar(double* x, size_t begin, size_t n, double factor) {
+            for (size_t i = begin; i < n; ++i) x[i] *= factor;
+        }
+
+#if defined(SIMD_KERNELS_X86)
+        // ---------- AVX2, 4 числа за шаг ----------
+
+        SIMD_TARGET_AVX2 inline void sums_avx2(const double* x, size_t n, double shift, Sums& acc) {
+            size_t i = 0;
+            if (n >= 4) {
+                __m256d vmin = _mm256_set1_pd(acc.min);
+                __m256d vmax = _mm256_set1_pd(acc.max);
+                __m256d vsum = _mm256_setzero_pd();
+                __m256d vsq = _mm256_setzero_pd();
+                const __m256d vshift = _mm256_set1_pd(shift);
+                for (; i + 4 <= n; i += 4) {
+                    __m256d v = _mm256_loadu_pd(x + i);
+                    vmin = _mm256_min_pd(vmin, v);
+                    vmax = _mm256_max_pd(vmax, v);
+                    __m256d d = _mm256_sub_pd(v, vshift);
+                    vsum = _mm256_add_pd(vsum, d);
+                    vsq = _mm256_add_pd(vsq, _mm256_mul_pd(d, d));
+                }
+                alignas(32) double lanes[4][4];
+                _mm256_store_pd(lanes[0], vmin);
+                _mm256_store_pd(lanes[1], vmax);
+                _mm256_store_pd(lanes[2], vsum);
+                _mm256_store_pd(lanes[3], vsq);
+                for (int k = 0; k < 4; ++k) {
+                    acc.min = std::min(acc.min, lanes[0][k]);
+                    acc.max = std::max(acc.max, lanes[1][k]);
+                    acc.sum += lanes[2][k];
+                    acc.sum_sq += lanes[3][k];
+                }
+            }
+            sums_scalar(x, i, n, shift, acc);
+        }
+
+        SIMD_TARGET_AVX2 inline void lag_diff_avx2(const double* x, size_t begin, size_t n, size_t lag, double* out) {
+            size_t i = begin;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(x + i - lag)));
+            }
+            lag_diff_scalar(x, i, n, lag, out);
+        }
+
+        SIMD_TARGET_AVX2 inline void lag_diff_sq_avx2(const double* x, size_t begin, size_t n, size_t lag, double shift, double* out) {
+            const __m256d vshift = _mm256_set1_pd(shift);
+            size_t i = begin;
+            for (; i + 4 <= n; i += 4) {
+                __m256d a = _mm256_sub_pd(_mm256_loadu_pd(x + i), vshift);
+                __m256d b = _mm256_sub_pd(_mm256_loadu_pd(x + i - lag), vshift);
+                _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b)));
+            }
+            lag_diff_sq_scalar(x, i, n, lag, shift, out);
+        }
+
+        SIMD_TARGET_AVX2 inline void returns_avx2(const double* x, size_t n, double* out) {
+            const __m256d one = _mm256_set1_pd(1.0);
+            size_t i = 0;
+            for (; i + 5 <= n; i += 4) {
+                __m256d next = _mm256_loadu_pd(x + i + 1);
+                __m256d prev = _mm256_loadu_pd(x + i);
+                _mm256_storeu_pd(out + i, _mm256_sub_pd(_mm256_div_pd(next, prev), one));
+            }
+            returns_scalar(x, i, n, out);
+        }
+
+        SIMD_TARGET_AVX2 inline void gains_losses_avx2(const double* x, size_t n, double* gains, double* losses) {
+            const __m256d zero = _mm256_setzero_pd();
+            size_t i = 0;
+            for (; i + 5 <= n; i += 4) {
+                __m256d change = _mm256_sub_pd(_mm256_loadu_pd(x + i + 1), _mm256_loadu_pd(x + i));
+                _mm256_storeu_pd(gains + i, _mm256_max_pd(change, zero));
+                _mm256_storeu_pd(losses + i, _mm256_max_pd(_mm256_sub_pd(zero, change), zero));
+            }
+            gains_losses_scalar(x, i, n, gains, losses);
+        }
+
+        SIMD_TARGET_AVX2 inline void scale_avx2(double* x, size_t begin, size_t n, double factor) {
+            const __m256d f = _mm256_set1_pd(factor);
+            size_t i = begin;
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), f));
+            }
+            scale_scalar(x, i, n, factor);
+        }
+
+        // ---------- AVX-512, 8 чисел за шаг ----------
+
+        SIMD_TARGET_AVX512 inline void sums_avx512(const double* x, size_t n, double shift, Sums& acc) {
+            size_t i = 0;
+            if (n >= 8) {
+                // min/max начинаются с первых 8 чисел, а маскированные min/max берут проходное значение
+                // из самого аккумулятора: у _mm512_min_pd оно неопределённое, и GCC -Wall ругается на него
+                const __mmask8 all = 0xFF;
+                __m512d vmin = _mm512_loadu_pd(x);
+                __m512d vmax = vmin;
+                __m512d vsum = _mm512_setzero_pd();
+                __m512d vsq = _mm512_setzero_pd();
+                const __m512d vshift = _mm512_set1_pd(shift);
+                for (; i + 8 <= n; i += 8) {
+                    __m512d v = _mm512_loadu_pd(x + i);
+                    vmin = _mm512_mask_min_pd(vmin, all, vmin, v);
+                    vmax = _mm512_mask_max_pd(vmax, all, vmax, v);
+                    __m512d d = _mm512_sub_pd(v, vshift);
+                    vsum = _mm512_add_pd(vsum, d);
+                    vsq = _mm512_add_pd(vsq, _mm512_mul_pd(d, d));
+                }
+                alignas(64) double lanes[4][8];
+                _mm512_store_pd(lanes[0], vmin);
+                _mm512_store_pd(lanes[1], vmax);
+                _mm512_store_pd(lanes[2], vsum);
+                _mm512_store_pd(lanes[3], vsq);
+                for (int k = 0; k < 8; ++k) {
+                    acc.min = std::min(acc.min, lanes[0][k]);
+                    acc.max = std::max(acc.max, lanes[1][k]);
+                    acc.sum += lanes[2][k];
+                    acc.sum_sq += lanes[3][k];
+                }
+            }
+            sums_scalar(x, i, n, shift, acc);
+        }
+
+        SIMD_TARGET_AVX512 inline void lag_diff_avx512(const double* x, size_t begin, size_t n, size_t lag, double* out) {
+            size_t i = begin;
+            for (; i + 8 <= n; i += 8) {
+                _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(x + i - lag)));
+            }
+            lag_diff_scalar(x, i, n, lag, out);
+        }
+
+        SIMD_TARGET_AVX512 inline void lag_diff_sq_avx512(const double* x, size_t begin, size_t n, size_t lag, double shift, double* out) {
+            const __m512d vshift = _mm512_set1_pd(shift);
+            size_t i = begin;
+            for (; i + 8 <= n; i += 8) {
+                __m512d a = _mm512_sub_pd(_mm512_loadu_pd(x + i), vshift);
+                __m512d b = _mm512_sub_pd(_mm512_loadu_pd(x + i - lag), vshift);
+                _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_mul_pd(a, a), _mm512_mul_pd(b, b)));
+            }
+            lag_diff_sq_scalar(x, i, n, lag, shift, out);
+        }
+
+        SIMD_TARGET_AVX512 inline void returns_avx512(const double* x, size_t n, double* out) {
+            const __m512d one = _mm512_set1_pd(1.0);
+            size_t i = 0;
+            for (; i + 9 <= n; i += 8) {
+                __m512d next = _mm512_loadu_pd(x + i + 1);
+                __m512d prev = _mm512_loadu_pd(x + i);
+                _mm512_storeu_pd(out + i, _mm512_sub_pd(_mm512_div_pd(next, prev), one));
+            }
+            returns_scalar(x, i, n, out);
+        }
+
+        SIMD_TARGET_AVX512 inline void gains_losses_avx512(const double* x, size_t n, double* gains, double* losses) {
+            // max маскированный, как в sums_avx512: проходное значение - ноль, а не неопределённое
+            const __mmask8 all = 0xFF;
+            const __m512d zero = _mm512_setzero_pd();
+            size_t i = 0;
+            for (; i + 9 <= n; i += 8) {
+                __m512d change = _mm512_sub_pd(_mm512_loadu_pd(x + i + 1), _mm512_loadu_pd(x + i));
+                _mm512_storeu_pd(gains + i, _mm512_mask_max_pd(zero, all, change, zero));
+                _mm512_storeu_pd(losses + i, _mm512_mask_max_pd(zero, all, _mm512_sub_pd(zero, change), zero));
+            }
+            gains_losses_scalar(x, i, n, gains, losses);
+        }
+
+        SIMD_TARGET_AVX512 inline void scale_avx512(double* x, size_t begin, size_t n, double factor) {
+            const __m512d f = _mm512_set1_pd(factor);
+            size_t i = begin;
+            for (; i + 8 <= n; i += 8) {
+                _mm512_storeu_pd(x + i, _mm512_mul_pd(_mm512_loadu_pd(x + i), f));
+            }
+            scale_scalar(x, i, n, factor);
+        }
+#endif
+
+        // ---------- диспетчеризация ----------
+
+        inline void sums(const double* x, size_t n, double shift, Sums& acc) {
+#if defined(SIMD_KERNELS_X86)
+            switch (static_cast<Level>(active().load(std::memory_order_relaxed))) {
+            case Level::Avx512: sums_avx512(x, n, shift, acc); return;
+            case Level::Avx2: sums_avx2(x, n, shift, acc); return;
+            default: break;
+            }
+#endif
+            sums_scalar(x, 0, n, shift, acc);
+        }
+
+        inline void lag_diff(const double* x, size_t begin, size_t n, size_t lag, double* out) {
+#if defined(SIMD_KERNELS_X86)
+            switch (static_cast<Level>(active().load(std::memory_order_relaxed))) {
+            case Level::Avx512: lag_diff_avx512(x, begin, n, lag, out); return;
+            case Level::Avx2: lag_diff_avx2(x, begin, n, lag, out); return;
+            default: break;
+            }
+#endif
+            lag_diff_scalar(x, begin, n, lag, out);
+        }
+
+        inline void lag_diff_sq(const double* x, size_t begin, size_t n, size_t lag, double shift, double* out) {
+#if defined(SIMD_KERNELS_X86)
+            switch (static_cast<Level>(active().load(std::memory_order_relaxed))) {
+            case Level::Avx512: lag_diff_sq_avx512(x, begin, n, lag, shift, out); return;
+            case Level::Avx2: lag_diff_sq_avx2(x, begin, n, lag, shift, out); return;
+            default: break;
+            }
+#endif
+            lag_diff_sq_scalar(x, begin, n, lag, shift, out);
+        }
+
+        inline void returns(const double* x, size_t n, double* out) {
+#if defined(SIMD_KERNELS_X86)
+            switch (static_cast<Level>(active().load(std::memory_order_relaxed))) {
+            case Level::Avx512: returns_avx512(x, n, out); return;
+            case Level::Avx2: returns_avx2(x, n, out); return;
+            default: break;
+            }
+#endif
+            returns_scalar(x, 0, n, out);
+        }
+
+        inline void gains_losses(const double* x, size_t n, double* gains, double* losses) {
+#if defined(SIMD_KERNELS_X86)
+            switch (static_cast<Level>(active().load(std::memory_order_relaxed))) {
+            case Level::Avx512: gains_losses_avx512(x, n, gains, losses); return;
+            case Level::Avx2: gains_losses_avx2(x, n, gains, losses); return;
+            default: break;
+            }
+#endif
+            gains_losses_scalar(x, 0, n, gains, losses);
+        }
+
+        inline void scale(double* x, size_t begin, size_t n, double factor) {
+#if defined(SIMD_KERNELS_X86)
+            switch (static_cast<Level>(active().load(std::memory_order_relaxed))) {
+            case Level::Avx512: scale_avx512(x, begin, n, factor); return;
+            case Level::Avx2: scale_avx2(x, begin, n, factor); return;
+            default: break;
+            }
+#endif
+            scale_scalar(x, begin, n, factor);
+        }
+
+        inline double window_sum(const double* x, size_t end, size_t length) {
+            double sum = 0.0;
+            for (size_t i = end - length; i < end; ++i) sum += x[i];
+            return sum;
+        }
+
+        constexpr double not_ready = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    inline Level active_level() {
+        return static_cast<Level>(detail::active().load(std::memory_order_relaxed));
+    }
+
+    // Переключение уровня (для сравнения в бенчмарках); выше поддерживаемого не поднимается
+    inline Level set_level(Level level) {
+        Level applied = std::min(level, detect_level());
+        detail::active().store(static_cast<int>(applied), std::memory_order_relaxed);
+        return applied;
+    }
+
+    // min, max, среднее и дисперсия за один проход
+    inline SeriesStats stats(Span<const double> x) {
+        SeriesStats result{ x.size(), 0.0, 0.0, 0.0, 0.0 };
+        if (x.empty()) return result;
+        // Сдвиг на первое значение уменьшает потерю точности в сумме квадратов
+        const double shift = x[0];
+        detail::Sums acc{ x[0], x[0], 0.0, 0.0 };
+        detail::sums(x.data(), x.size(), shift, acc);
+        double n = static_cast<double>(x.size());
+        double mean_shifted = acc.sum / n;
+        result.min = acc.min;
+        result.max = acc.max;
+        result.mean = shift + mean_shifted;
+        result.variance = std::max(0.0, acc.sum_sq / n - mean_shifted * mean_shifted);
+        return result;
+    }
+
+    // Доходности свечей: out[i] = x[i + 1] / x[i] - 1, размер на единицу меньше ряда
+    inline IndicatorSeries returns(Span<const double> x) {
+        IndicatorSeries out(x.size() > 1 ? x.size() - 1 : 0);
+        if (!out.empty()) detail::returns(x.data(), x.size(), out.data());
+        return out;
+    }
+
+    // Скользящая средняя; out[i] - среднее x[i - length + 1 .. i]
+    inline IndicatorSeries sma(Span<const double> x, int length) {
+        const size_t n = x.size();
+        const size_t len = static_cast<size_t>(std::max(length, 1));
+        IndicatorSeries out(n, detail::not_ready);
+        if (n < len) return out;
+
+        detail::lag_diff(x.data(), len, n, len, out.data());
+        // Сумма пересчитывается заново раз в 64 окна, как в SmaIndicator
+        const size_t recompute = len * 64;
+        double sum = detail::window_sum(x.data(), len, len);
+        out[len - 1] = sum;
+        for (size_t i = len; i < n; ++i) {
+            sum = (i + 1) % recompute == 0 ? detail::window_sum(x.data(), i + 1, len) : sum + out[i];
+            out[i] = sum;
+        }
+        detail::scale(out.data(), len - 1, n, 1.0 / len);
+        return out;
+    }
+
+    // Скользящее стандартное отклонение (генеральной совокупности) по окну length
+    inline IndicatorSeries stddev(Span<const double> x, int length) {
+        const size_t n = x.size();
+        const size_t len = static_cast<size_t>(std::max(length, 1));
+        IndicatorSeries out(n, detail::not_ready);
+        if (n < len) return out;
+
+        const double shift = x[0];
+        IndicatorSeries sq_delta(n);
+        detail::lag_diff(x.data(), len, n, len, out.data());
+        detail::lag_diff_sq(x.data(), len, n, len, shift, sq_delta.data());
+
+        auto window_sums = [&](size_t end, double& sum, double& sum_sq) {
+            sum = 0.0;
+            sum_sq = 0.0;
+            for (size_t i = end - len; i < end; ++i) {
+                double d = x[i] - shift;
+                sum += d;
+                sum_sq += d * d;
+            }
+        };
+        auto to_stddev = [len](double sum, double sum_sq) {
+            double mean = sum / len;
+            return std::sqrt(std::max(0.0, sum_sq / len - mean * mean));
+        };
+
+        const size_t recompute = len * 64;
+        double sum;
+        double sum_sq;
+        window_sums(len, sum, sum_sq);
+        out[len - 1] = to_stddev(sum, sum_sq);
+        for (size_t i = len; i < n; ++i) {
+            if ((i + 1) % recompute == 0) {
+                window_sums(i + 1, sum, sum_sq);
+            }
+            else {
+                sum += out[i];
+                sum_sq += sq_delta[i];
+            }
+            out[i] = to_stddev(sum, sum_sq);
+        }
+        return out;
+    }
+
+    // EMA с засевом SMA первых length цен, как EmaIndicator; рекуррентность не векторизуется
+    inline IndicatorSeries ema(Span<const double> x, int length) {
+        const size_t n = x.size();
+        const size_t len = static_cast<size_t>(std::max(length, 1));
+        IndicatorSeries out(n, detail::not_ready);
+        if (n < len) return out;
+
+        const double alpha = 2.0 / (len + 1.0);
+        double value = detail::window_sum(x.data(), len, len) / len;
+        out[len - 1] = value;
+        for (size_t i = len; i < n; ++i) {
+            value += alpha * (x[i] - value);
+            out[i] = value;
+        }
+        return out;
+    }
+
+    // RSI со сглаживанием Уайлдера, как RsiIndicator: out[i] готов начиная с i = period
+    inline IndicatorSeries rsi(Span<const double> x, int period) {
+        const size_t n = x.size();
+        const size_t p = static_cast<size_t>(std::max(period, 1));
+        IndicatorSeries out(n, detail::not_ready);
+        if (n < p + 1) return out;
+
+        // gains[i] / losses[i] - изменение от свечи i к i + 1
+        IndicatorSeries gains(n - 1);
+        IndicatorSeries losses(n - 1);
+        detail::gains_losses(x.data(), n, gains.data(), losses.data());
+
+        auto to_rsi = [](double avg_gain, double avg_loss) {
+            if (avg_loss == 0.0) return 100.0;
+            return 100.0 - (100.0 / (1.0 + avg_gain / avg_loss));
+        };
+
+        double avg_gain = 0.0;
+        double avg_loss = 0.0;
+        for (size_t i = 0; i < p; ++i) {
+            avg_gain += gains[i] / p;
+            avg_loss += losses[i] / p;
+        }
+        out[p] = to_rsi(avg_gain, avg_loss);
+        for (size_t i = p + 1; i < n; ++i) {
+            avg_gain = (avg_gain * (p - 1) + gains[i - 1]) / p;
+            avg_loss = (avg_loss * (p - 1) + losses[i - 1]) / p;
+            out[i] = to_rsi(avg_gain, avg_loss);
+        }
+        return out;
+    }
+}
+
+#endif // SIMD_KERNELS_HPP
@@ -0,0 +1,175 @@
+#ifndef STREAMING_INDICATORS_HPP
+#define STREAMING_INDICATORS_HPP
+
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Индикатор с состоянием: засевается историей один раз, затем обновляется по одной свече за O(1)
+class StreamingIndicator {
+public:
+    virtual ~StreamingIndicator() = default;
+
+    // Добавляет цену закрытия очередной закрытой свечи
+    virtual void update(double close) = 0;
+    // Значение индикатора с учётом ещё не закрытой свечи, состояние не меняется
+    virtual double preview(double close) const = 0;
+    // Значение по закрытым свечам
+    virtual double value() const = 0;
+    // Сколько цен нужно для первого значения
+    virtual size_t required() const = 0;
+    virtual void reset() = 0;
+
+    size_t count() const { return count_; }
+    bool is_ready(bool with_pending = false) const { return count_ + (with_pending ? 1 : 0) >= required(); }
+
+protected:
+    size_t count_ = 0;
+};
+
+// Простая скользящая средняя на кольцевом буфере
+class SmaIndicator : public StreamingIndicator {
+public:
+    explicit SmaIndicator(int length) : length_(length > 0 ? length : 1), window_(length_, 0.0) {}
+
+    void update(double close) override {
+        size_t pos = count_ % length_;
+        if (count_ >= length_) sum_ -= window_[pos];
+        window_[pos] = close;
+        sum_ += close;
+        ++count_;
+        // Периодически пересчитываем сумму, чтобы не копилась ошибка округления
+        if (count_ % (length_ * 64) == 0) {
+            sum_ = 0.0;
+            for (double v : window_) sum_ += v;
+        }
+    }
+
+    double preview(double close) const override {
+        if (count_ >= length_) {
+            return (sum_ - window_[count_ % length_] + close) / length_;
+        }
+        return (sum_ + close) / length_;
+    }
+
+    double value() const override { return sum_ / length_; }
+    size_t required() const override { return length_; }
+
+    void reset() override {
+        count_ = 0;
+        sum_ = 0.0;
+        std::fill(window_.begin(), window_.end(), 0.0);
+    }
+
+private:
+    size_t length_;
+    std::vector<double> window_;
+    double sum_ = 0.0;
+};
+
+// Экспоненциальная скользящая средняя, первое значение - SMA первых length цен
+class EmaIndicator : public StreamingIndicator {
+public:
+    explicit EmaIndicator(int length)
+        : length_(length > 0 ? length : 1), alpha_(2.0 / (length_ + 1.0)) {}
+
+    void update(double close) override {
+        ++count_;
+        if (count_ < length_) {
+            ema_ += close;
+        }
+        else if (count_ == length_) {
+            ema_ = (ema_ + close) / length_;
+        }
+        else {
+            ema_ += alpha_ * (close - ema_);
+        }
+    }
+
+    double preview(double close) const override {
+        if (count_ + 1 < length_) return 0.0;
+        if (count_ + 1 == length_) return (ema_ + close) / length_;
+        return ema_ + alpha_ * (close - ema_);
+    }
+
+    double value() const override { return count_ >= length_ ? ema_ : 0.0; }
+    size_t required() const override { return length_; }
+
+    void reset() override {
+        count_ = 0;
+        ema_ = 0.0;
+    }
+
+private:
+    size_t length_;
+    double alpha_;
+    double ema_ = 0.0;
+};
+
+// RSI со сглаживанием Уайлдера: хранит avg_gain / avg_loss между свечами
+class RsiIndicator : public StreamingIndicator {
+public:
+    explicit RsiIndicator(int period) : period_(period > 0 ? period : 1) {}
+
+    void update(double close) override {
+        if (count_ > 0) {
+            double change = close - last_close_;
+            double gain = change > 0 ? change : 0.0;
+            double loss = change < 0 ? -change : 0.0;
+            if (count_ <= period_) {
+                // Первые period изменений - простое среднее
+                avg_gain_ += gain / period_;
+                avg_loss_ += loss / period_;
+            }
+            else {
+                avg_gain_ = (avg_gain_ * (period_ - 1) + gain) / period_;
+                avg_loss_ = (avg_loss_ * (period_ - 1) + loss) / period_;
+            }
+        }
+        last_close_ = close;
+        ++count_;
+    }
+
+    double preview(double close) const override {
+        if (count_ == 0) return 50.0;
+        double change = close - last_close_;
+        double gain = change > 0 ? change : 0.0;
+        double loss = change < 0 ? -change : 0.0;
+        double avg_gain = avg_gain_;
+        double avg_loss = avg_loss_;
+        if (count_ <= period_) {
+            avg_gain += gain / period_;
+            avg_loss += loss / period_;
+        }
+        else {
+            avg_gain = (avg_gain * (period_ - 1) + gain) / period_;
+            avg_loss = (avg_loss * (period_ - 1) + loss) / period_;
+        }
+        return to_rsi(avg_gain, avg_loss);
+    }
+
+    double value() const override { return to_rsi(avg_gain_, avg_loss_); }
+    size_t required() const override { return period_ + 1; }
+
+    void reset() override {
+        count_ = 0;
+        avg_gain_ = 0.0;
+        avg_loss_ = 0.0;
+        last_close_ = 0.0;
+    }
+
+private:
+    size_t period_;
+    double avg_gain_ = 0.0;
+    double avg_loss_ = 0.0;
+    double last_close_ = 0.0;
+
+    static double to_rsi(double avg_gain, double avg_loss) {
+        if (avg_loss == 0.0) return 100.0;
+        double rs = avg_gain / avg_loss;
+        return 100.0 - (100.0 / (1.0 + rs));
+    }
+};
+
+#endif // STREAMING_INDICATORS_HPP
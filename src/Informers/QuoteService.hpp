@@ -0,0 +1,225 @@
+#ifndef QUOTE_SERVICE_HPP
+#define QUOTE_SERVICE_HPP
+
+#include "./Informer.hpp"
+#include "../Utils/Metrics.hpp"
+#include <chrono>
+#include <exception>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// Информер, который умеет получать цены нескольких символов одним запросом
+// (например, общий тикер биржи). Подмешивается к реализации Informer.
+class BatchQuoteSource {
+public:
+    virtual std::map<std::string, double> get_symbols_now(const std::vector<std::string>& symbols) = 0;
+    virtual ~BatchQuoteSource() = default;
+};
+
+// Сервис текущих цен по рынкам: одновременные запросы одного символа склеиваются в один,
+// свежая цена переиспользуется в течение fresh_for, а для информеров с BatchQuoteSource
+// символы, запрошенные в течение batch_window, уходят одним запросом.
+class QuoteService {
+public:
+    static QuoteService& getInstance() {
+        static QuoteService instance;
+        return instance;
+    }
+
+    double get_symbol_now(const std::shared_ptr<Informer>& informer, const std::string& symbol) {
+        const auto now = std::chrono::steady_clock::now();
+        const bool batching = dynamic_cast<BatchQuoteSource*>(informer.get()) != nullptr;
+        Market& market = get_market(*informer);
+
+        std::shared_future<double> result;
+        std::shared_ptr<Batch> batch_to_run;
+        {
+            std::lock_guard<std::mutex> lock(market.mutex);
+
+            auto fresh = market.quotes.find(symbol);
+            if (fresh != market.quotes.end() && now - fresh->second.received < fresh_for_) {
+                fresh_quotes_.add();
+                return fresh->second.price;
+            }
+
+            auto in_flight = market.in_flight.find(symbol);
+            if (in_flight != market.in_flight.end()) {
+                joined_quotes_.add();
+                result = in_flight->second;
+            }
+            else {
+                fetched_quotes_.add();
+                // Присоединяемся к открытой пачке или открываем новую и ведём её сами
+                if (!market.open_batch) {
+                    market.open_batch = std::make_shared<Batch>();
+                    batch_to_run = market.open_batch;
+                }
+                auto& promise = market.open_batch->promises[symbol];
+                result = promise.get_future().share();
+                market.in_flight[symbol] = result;
+                if (!batching) {
+                    // Информер без пакетного запроса: пачку из одного символа не ждём
+                    market.open_batch.reset();
+                }
+            }
+        }
+
+        if (batch_to_run) {
+            if (batching) {
+                std::this_thread::sleep_for(batch_window_);
+                std::lock_guard<std::mutex> lock(market.mutex);
+                if (market.open_batch == batch_to_run) market.open_batch.reset();
+            }
+            run_batch(informer, market, *batch_to_run);
+        }
+        return result.get();
+    }
+
+    // Цены списка символов одного рынка (портфельный бот): свежие берутся из памяти, уже запрошенные другими
+    // ждём, остальные уходят одной пачкой сразу, без batch_window - список и так известен целиком.
+    // Символов, цену которых получить не удалось, в ответе нет
+    std::map<std::string, double> get_symbols_now(const std::shared_ptr<Informer>& informer, const std::vector<std::string>& symbols) {
+        const auto now = std::chrono::steady_clock::now();
+        Market& market = get_market(*informer);
+
+        std::map<std::string, double> prices;
+        std::map<std::string, std::shared_future<double>> waiting;
+        Batch batch;
+        {
+            std::lock_guard<std::mutex> lock(market.mutex);
+            for (const auto& symbol : symbols) {
+                if (prices.count(symbol) || waiting.count(symbol)) continue;
+
+                auto fresh = market.quotes.find(symbol);
+                if (fresh != market.quotes.end() && now - fresh->second.received < fresh_for_) {
+                    fresh_quotes_.add();
+                    prices[symbol] = fresh->second.price;
+                    continue;
+                }
+
+                auto in_flight = market.in_flight.find(symbol);
+                if (in_flight != market.in_flight.end()) {
+                    joined_quotes_.add();
+                    waiting[symbol] = in_flight->second;
+                    continue;
+                }
+
+                fetched_quotes_.add();
+                std::shared_future<double> result = batch.promises[symbol].get_future().share();
+                market.in_flight[symbol] = result;
+                waiting[symbol] = result;
+            }
+        }
+
+        if (!batch.promises.empty()) run_batch(informer, market, batch);
+        for (auto& item : waiting) {
+            try {
+                prices[item.first] = item.second.get();
+            }
+            catch (...) {
+                // Ошибку символа увидит вызывающий по его отсутствию в ответе
+            }
+        }
+        return prices;
+    }
+
+    void set_fresh_for(std::chrono::milliseconds value) { fresh_for_ = value; }
+    void set_batch_window(std::chrono::milliseconds value) { batch_window_ = value; }
+
+private:
+    struct Quote {
+        double price;
+        std::chrono::steady_clock::time_point received;
+    };
+
+    struct Batch {
+        std::map<std::string, std::promise<double>> promises;
+    };
+
+    struct Market {
+        std::mutex mutex;
+        std::unordered_map<std::string, Quote> quotes;
+        std::unordered_map<std::string, std::shared_future<double>> in_flight;
+        std::shared_ptr<Batch> open_batch;
+    };
+
+    std::mutex markets_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<Market>> markets_;
+    std::chrono::milliseconds fresh_for_{ 1000 };
+    std::chrono::milliseconds batch_window_{ 20 };
+    ShardedCounter& fresh_quotes_ = quote_counter("fresh");     // свежая цена из памяти
+    ShardedCounter& joined_quotes_ = quote_counter("joined");   // дождались чужого запроса того же символа
+    ShardedCounter& fetched_quotes_ = quote_counter("fetched"); // запрос к информеру
+
+    static ShardedCounter& quote_counter(const std::string& result) {
+        return Metrics::getInstance().counter("tradesnake_quote_requests_total",
+            "Current price requests by how they were served", { {"result", result} });
+    }
+
+    QuoteService() = default;
+    QuoteService(const QuoteService&) = delete;
+    QuoteService& operator=(const QuoteService&) = delete;
+
+    // Рынок определяется типом информера, как и в CandleCache
+    Market& get_market(const Informer& informer) {
+        std::lock_guard<std::mutex> lock(markets_mutex_);
+        auto& market = markets_[typeid(informer).name()];
+        if (!market) market = std::make_unique<Market>();
+        return *market;
+    }
+
+    void run_batch(const std::shared_ptr<Informer>& informer, Market& market, Batch& batch) {
+        // Пачка закрыта: новых символов в неё уже не добавят
+        std::vector<std::string> symbols;
+        symbols.reserve(batch.promises.size());
+        for (const auto& item : batch.promises) symbols.push_back(item.first);
+
+        std::map<std::string, double> prices;
+        std::map<std::string, std::exception_ptr> errors;
+        if (auto* source = dynamic_cast<BatchQuoteSource*>(informer.get())) {
+            try {
+                ScopedTimer timer(Metrics::informer_latency(typeid(*informer), "get_symbols_now"));
+                prices = source->get_symbols_now(symbols);
+            }
+            catch (...) {
+                for (const auto& symbol : symbols) errors[symbol] = std::current_exception();
+            }
+        }
+        for (const auto& symbol : symbols) {
+            if (prices.count(symbol) || errors.count(symbol)) continue;
+            try {
+                ScopedTimer timer(Metrics::informer_latency(typeid(*informer), "get_symbol_now"));
+                prices[symbol] = informer->get_symbol_now(symbol);
+            }
+            catch (...) {
+                errors[symbol] = std::current_exception();
+            }
+        }
+
+        const auto received = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(market.mutex);
+            for (const auto& symbol : symbols) {
+                auto price = prices.find(symbol);
+                if (price != prices.end()) {
+                    market.quotes[symbol] = { price->second, received };
+                }
+                market.in_flight.erase(symbol);
+            }
+        }
+        for (auto& item : batch.promises) {
+            auto price = prices.find(item.first);
+            if (price != prices.end()) item.second.set_value(price->second);
+            else item.second.set_exception(errors[item.first]);
+        }
+    }
+};
+
+#endif // QUOTE_SERVICE_HPP
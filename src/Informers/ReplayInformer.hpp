@@ -0,0 +1,210 @@
+#ifndef REPLAY_INFORMER_HPP
+#define REPLAY_INFORMER_HPP
+
+#include "./Informer.hpp"
+#include "../Data/CandleSeries.hpp"
+#include "../struct.hpp"
+#include "../Utils/Logger.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Тик записанной ленты цен
+struct ReplayTick {
+    int64_t timestamp; // мс от эпохи
+    double price;
+};
+
+// Информер без сети: воспроизводит записанные свечи и тики.
+// Свечи: <dir>/<символ>_<интервал>.csv, строки "timestamp_ms,open,high,low,close,volume,turnover";
+// тики: <dir>/<символ>_ticks.csv, строки "timestamp_ms,price" (без файла тиками служат цены закрытия
+// самого мелкого записанного интервала). В имени файла символы кроме [A-Za-z0-9._-] заменяются на '_'.
+// speed > 0 - записанное время идёт в speed раз быстрее реального; speed == 0 - без ожидания,
+// каждый запрос текущей цены сдвигает ленту символа на один тик. Результат не зависит от сети и времени запуска.
+class ReplayInformer : public Informer {
+public:
+    explicit ReplayInformer(std::string directory = "", double speed = 0.0)
+        : directory_(std::move(directory)), speed_(std::max(0.0, speed)), started_(std::chrono::steady_clock::now()) {
+    }
+
+    // Ряд из памяти вместо файла (синтетические данные бенчмарка); добавлять до первого запроса цены символа
+    void add_candles(const std::string& symbol, const std::string& interval, CandleSeries candles) {
+        candles.sort();
+        std::lock_guard<std::mutex> lock(mutex_);
+        candles_[symbol + "|" + interval] = std::make_shared<const CandleSeries>(std::move(candles));
+    }
+
+    void add_ticks(const std::string& symbol, std::vector<ReplayTick> ticks) {
+        std::stable_sort(ticks.begin(), ticks.end(), [](const ReplayTick& a, const ReplayTick& b) {
+            return a.timestamp < b.timestamp;
+            });
+        std::lock_guard<std::mutex> lock(mutex_);
+        tapes_[symbol] = Tape{ std::move(ticks), 0, true };
+    }
+
+    // Воспроизведение заново с первого тика
+    void rewind() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        started_ = std::chrono::steady_clock::now();
+        for (auto& tape : tapes_) tape.second.cursor = 0;
+    }
+
+    double get_symbol_now(const std::string& symbol) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Tape& tape = tape_for(symbol);
+        if (tape.ticks.empty()) {
+            throw std::runtime_error("No recorded ticks for " + symbol);
+        }
+        if (speed_ == 0.0) {
+            double price = tape.ticks[tape.cursor].price;
+            if (tape.cursor + 1 < tape.ticks.size()) ++tape.cursor;
+            return price;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started_);
+        int64_t replay_time = tape.ticks.front().timestamp + static_cast<int64_t>(elapsed.count() * speed_);
+        auto it = std::upper_bound(tape.ticks.begin(), tape.ticks.end(), replay_time,
+            [](int64_t time, const ReplayTick& tick) { return time < tick.timestamp; });
+        return it == tape.ticks.begin() ? it->price : std::prev(it)->price;
+    }
+
+    std::vector<CandleData> get_symbol_historical(const std::string& symbol, const std::string& start_date,
+        const std::string& end_date, const std::string& interval) override {
+        std::shared_ptr<const CandleSeries> series;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            series = candles_for(symbol, interval);
+        }
+        std::vector<CandleData> result;
+        if (!series) return result;
+
+        int64_t start = std::stoll(start_date) * 1000;
+        int64_t end = (std::stoll(end_date) + 1) * 1000;
+        size_t first = series->lower_bound(start);
+        size_t last = series->lower_bound(end);
+        result.reserve(last > first ? last - first : 0);
+        for (size_t i = first; i < last; ++i) {
+            result.push_back(series->candle(i));
+        }
+        return result;
+    }
+
+private:
+    struct Tape {
+        std::vector<ReplayTick> ticks;
+        size_t cursor = 0;
+        bool loaded = false;
+    };
+
+    std::string directory_;
+    double speed_;
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point started_;
+    std::map<std::string, std::shared_ptr<const CandleSeries>> candles_; // ключ "символ|интервал"; nullptr - записи нет
+    std::map<std::string, Tape> tapes_;
+
+    static std::string file_name(const std::string& value) {
+        std::string result;
+        for (char c : value) {
+            bool safe = std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+            result += safe ? c : '_';
+        }
+        return result;
+    }
+
+    // Числа строки CSV; строка заголовка и пустые строки дают пустой результат
+    static std::vector<double> parse_line(const std::string& line, std::vector<int64_t>* first_as_int) {
+        std::vector<double> values;
+        if (line.empty() || !(std::isdigit(static_cast<unsigned char>(line[0])) || line[0] == '-')) return values;
+        const char* cursor = line.c_str();
+        while (*cursor != '\0') {
+            char* next = nullptr;
+            if (values.empty() && first_as_int != nullptr) {
+                first_as_int->push_back(std::strtoll(cursor, &next, 10));
+                values.push_back(0.0);
+            }
+            else {
+                values.push_back(std::strtod(cursor, &next));
+            }
+            if (next == cursor) return {};
+            cursor = next;
+            while (*cursor == ',' || *cursor == ' ' || *cursor == '\r' || *cursor == '\t') ++cursor;
+        }
+        return values;
+    }
+
+    std::shared_ptr<const CandleSeries> candles_for(const std::string& symbol, const std::string& interval) {
+        std::string key = symbol + "|" + interval;
+        auto it = candles_.find(key);
+        if (it != candles_.end()) return it->second;
+
+        std::shared_ptr<const CandleSeries> series;
+        if (!directory_.empty()) {
+            std::string path = directory_ + "/" + file_name(symbol) + "_" + file_name(interval) + ".csv";
+            std::ifstream file(path);
+            if (file) {
+                CandleSeries candles;
+                std::string line;
+                std::vector<int64_t> timestamps;
+                while (std::getline(file, line)) {
+                    timestamps.clear();
+                    std::vector<double> values = parse_line(line, &timestamps);
+                    if (values.size() < 7) continue;
+                    candles.push_back(timestamps[0], values[1], values[2], values[3], values[4], values[5], values[6]);
+                }
+                candles.sort();
+                series = std::make_shared<const CandleSeries>(std::move(candles));
+            }
+        }
+        candles_[key] = series;
+        return series;
+    }
+
+    Tape& tape_for(const std::string& symbol) {
+        Tape& tape = tapes_[symbol];
+        if (tape.loaded) return tape;
+        tape.loaded = true;
+
+        if (!directory_.empty()) {
+            std::ifstream file(directory_ + "/" + file_name(symbol) + "_ticks.csv");
+            std::string line;
+            std::vector<int64_t> timestamps;
+            while (file && std::getline(file, line)) {
+                timestamps.clear();
+                std::vector<double> values = parse_line(line, &timestamps);
+                if (values.size() < 2) continue;
+                tape.ticks.push_back({ timestamps[0], values[1] });
+            }
+        }
+        if (tape.ticks.empty()) {
+            // Записанных тиков нет - идём по ценам закрытия свечей
+            for (const char* interval : { "1", "5", "15", "30", "60", "d" }) {
+                std::shared_ptr<const CandleSeries> series = candles_for(symbol, interval);
+                if (!series || series->empty()) continue;
+                for (size_t i = 0; i < series->size(); ++i) {
+                    tape.ticks.push_back({ series->timestamp(i), series->close()[i] });
+                }
+                break;
+            }
+        }
+        std::stable_sort(tape.ticks.begin(), tape.ticks.end(), [](const ReplayTick& a, const ReplayTick& b) {
+            return a.timestamp < b.timestamp;
+            });
+        if (tape.ticks.empty()) {
+            log_warn().symbol(symbol) << "ReplayInformer: no recorded ticks or candles for " << symbol;
+        }
+        return tape;
+    }
+};
+
+#endif // REPLAY_INFORMER_HPP
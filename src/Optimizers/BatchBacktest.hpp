@@ -0,0 +1,342 @@
+#ifndef BATCH_BACKTEST_HPP
+#define BATCH_BACKTEST_HPP
+
+#include "../StrategyFactory.hpp"
+#include "../TradeBots/TradeBot.hpp"
+#include "../Cache/CandleCache.hpp"
+#include "../Data/CandleSeries.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "../struct.hpp"
+#include "../Utils/Logger.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Задание пакетного бэктеста: символ, период [start, end] в секундах и полные параметры бота
+struct BacktestJob {
+    std::string symbol;
+    long long start;
+    long long end;
+    std::map<std::string, std::string> params;
+};
+
+// Результат одного задания
+struct BacktestJobResult {
+    BacktestSummary summary;
+    size_t candles;
+    bool ok;
+    std::string error;
+};
+
+// Сводка по успешным заданиям
+struct BacktestAggregate {
+    size_t jobs;               // успешных заданий
+    size_t failed;
+    double mean_return;        // return_percent: среднее, медиана, крайние значения и разброс
+    double median_return;
+    double min_return;
+    double max_return;
+    double stdev_return;
+    double profitable_share;   // доля заданий с pnl > 0
+    double mean_max_drawdown;
+    double worst_max_drawdown;
+    long long trades;
+    long long winning_trades;
+};
+
+struct BatchBacktestResult {
+    std::vector<BacktestJobResult> results; // в порядке заданий
+    BacktestAggregate total;
+    std::map<std::string, BacktestAggregate> by_symbol;
+    size_t candle_windows;                  // рядов свечей, загруженных на все задания
+};
+
+// Пакетный бэктест одной стратегии по списку заданий (символ, период, параметры) - скользящие окна,
+// несколько символов, разные параметры. Пересекающиеся и соседние периоды одного символа и интервала
+// сливаются в одно окно: его свечи загружаются один раз, а каждое задание считается на своём участке
+// общего ряда без копирования. Задания выполняются параллельно в общем пуле потоков.
+class BatchBacktest {
+public:
+    static constexpr size_t max_jobs = 10000;
+
+    // Задания из JSON-массива: [{"symbol": ..., "start_date": ..., "end_date": ..., "strategy_parameters": {...}}];
+    // отсутствующие поля берутся из базовых параметров
+    static void add_jobs(const nlohmann::json& jobs_json, const std::map<std::string, std::string>& base,
+        std::vector<BacktestJob>& jobs) {
+        if (!jobs_json.is_array()) {
+            throw std::invalid_argument("jobs must be an array");
+        }
+        for (const auto& job_json : jobs_json) {
+            if (!job_json.is_object()) {
+                throw std::invalid_argument("Each job must be an object");
+            }
+            std::map<std::string, std::string> params = base;
+            auto overrides = job_json.find("strategy_parameters");
+            if (overrides != job_json.end()) merge_params(*overrides, params);
+            std::string symbol = job_json.contains("symbol") ? text(job_json.at("symbol")) : value_of(params, "symbol");
+            long long start = job_json.contains("start_date") ? seconds(job_json.at("start_date"), "start_date")
+                : seconds(value_of(params, "start_date"), "start_date");
+            long long end = job_json.contains("end_date") ? seconds(job_json.at("end_date"), "end_date")
+                : seconds(value_of(params, "end_date"), "end_date");
+            add_job(symbol, start, end, std::move(params), jobs);
+        }
+    }
+
+    // Скользящие окна: {"symbols": [...], "start_date": ..., "end_date": ..., "window": секунды, "step": секунды}
+    // дают по заданию на каждый символ и каждое окно длиной window со сдвигом step (по умолчанию - без перекрытия)
+    static void add_walk_forward(const nlohmann::json& walk_json, const std::map<std::string, std::string>& base,
+        std::vector<BacktestJob>& jobs) {
+        if (!walk_json.is_object()) {
+            throw std::invalid_argument("walk_forward must be an object");
+        }
+        std::vector<std::string> symbols;
+        auto symbols_json = walk_json.find("symbols");
+        if (symbols_json != walk_json.end()) {
+            if (!symbols_json->is_array() || symbols_json->empty()) {
+                throw std::invalid_argument("walk_forward.symbols must be a non-empty array");
+            }
+            for (const auto& symbol : *symbols_json) symbols.push_back(text(symbol));
+        }
+        else {
+            symbols.push_back(value_of(base, "symbol"));
+        }
+        long long start = seconds(walk_json.at("start_date"), "walk_forward.start_date");
+        long long end = seconds(walk_json.at("end_date"), "walk_forward.end_date");
+        long long window = seconds(walk_json.at("window"), "walk_forward.window");
+        long long step = walk_json.contains("step") ? seconds(walk_json.at("step"), "walk_forward.step") : window;
+        if (window <= 0 || step <= 0) {
+            throw std::invalid_argument("walk_forward.window and walk_forward.step must be positive");
+        }
+        if (end - start + 1 < window) {
+            throw std::invalid_argument("walk_forward.window is longer than the period");
+        }
+        for (const auto& symbol : symbols) {
+            for (long long from = start; from + window - 1 <= end; from += step) {
+                add_job(symbol, from, from + window - 1, base, jobs);
+            }
+        }
+    }
+
+    static BatchBacktestResult run(int user_id, int strategy_id, int broker_id, const std::vector<BacktestJob>& jobs) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        const StrategyFactory& factory = StrategyFactory::getInstance();
+        BatchBacktestResult batch;
+        batch.results.resize(jobs.size(), BacktestJobResult{ {}, 0, false, {} });
+        batch.candle_windows = 0;
+        if (jobs.empty()) {
+            batch.total = aggregate(jobs, batch.results, nullptr);
+            return batch;
+        }
+
+        // Первый бот создаётся обычным путём: он определяет информер и комиссии брокера
+        std::unique_ptr<TradeBot> prototype = factory.createStrategy(strategy_id, user_id, -1, broker_id, jobs.front().params);
+        BacktestResources resources{ prototype->get_informer(), prototype->get_broker() };
+        if (!resources.informer) {
+            throw std::runtime_error("Broker " + std::to_string(broker_id) + " or its market type not found");
+        }
+
+        std::vector<std::string> intervals(jobs.size());
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            try {
+                intervals[i] = factory.validate(strategy_id, jobs[i].params).bot().interval;
+            }
+            catch (const std::exception& e) {
+                batch.results[i].error = e.what();
+            }
+        }
+        std::vector<size_t> job_window(jobs.size(), 0);
+        std::vector<Window> windows = merge_windows(jobs, intervals, batch.results, job_window);
+        batch.candle_windows = windows.size();
+
+        ThreadPool& pool = ThreadPool::shared();
+        pool.parallel_for(windows.size(), [&](size_t w) {
+            Window& window = windows[w];
+            try {
+                window.candles = CandleCache::getInstance().get_symbol_historical(resources.informer, window.symbol,
+                    std::to_string(window.start), std::to_string(window.end), window.interval);
+            }
+            catch (const std::exception& e) {
+                window.error = e.what();
+            }
+            });
+
+        pool.parallel_for(jobs.size(), [&](size_t i) {
+            BacktestJobResult& result = batch.results[i];
+            if (!result.error.empty()) return;
+            const Window& window = windows[job_window[i]];
+            if (!window.error.empty()) {
+                result.error = window.error;
+                return;
+            }
+            try {
+                size_t first = window.candles.lower_bound(TimeUtils::align_down(jobs[i].start, window.step) * 1000);
+                size_t last = window.candles.lower_bound((jobs[i].end + 1) * 1000);
+                BacktestResources::Scope scope(resources);
+                std::unique_ptr<TradeBot> bot = factory.createStrategy(strategy_id, user_id, -1, broker_id, jobs[i].params);
+                result.summary = bot->execute_historical_summary(window.candles, first, std::max(first, last));
+                result.candles = last > first ? last - first : 0;
+                result.ok = true;
+            }
+            catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            });
+
+        batch.total = aggregate(jobs, batch.results, nullptr);
+        for (const auto& job : jobs) {
+            if (!batch.by_symbol.count(job.symbol)) {
+                batch.by_symbol[job.symbol] = aggregate(jobs, batch.results, &job.symbol);
+            }
+        }
+
+        size_t candles = 0;
+        for (const auto& window : windows) candles += window.candles.size();
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start_time).count();
+        log_info() << "Batch backtest: " << jobs.size() << " jobs over " << windows.size() << " candle windows ("
+            << candles << " candles) in " << duration << " milliseconds";
+        return batch;
+    }
+
+private:
+    // Общий ряд свечей для пересекающихся периодов одного символа и интервала
+    struct Window {
+        std::string symbol;
+        std::string interval;
+        long long step;
+        long long start;
+        long long end;
+        CandleSeries candles;
+        std::string error;
+    };
+
+    static void add_job(const std::string& symbol, long long start, long long end,
+        std::map<std::string, std::string> params, std::vector<BacktestJob>& jobs) {
+        if (start > end) {
+            throw std::invalid_argument("start_date must not be later than end_date");
+        }
+        if (jobs.size() >= max_jobs) {
+            throw std::invalid_argument("Too many backtest jobs (max " + std::to_string(max_jobs) + ")");
+        }
+        params["symbol"] = symbol;
+        params["start_date"] = std::to_string(start);
+        params["end_date"] = std::to_string(end);
+        jobs.push_back({ symbol, start, end, std::move(params) });
+    }
+
+    // Задания с ошибкой в results окна не получают
+    static std::vector<Window> merge_windows(const std::vector<BacktestJob>& jobs, const std::vector<std::string>& intervals,
+        const std::vector<BacktestJobResult>& results, std::vector<size_t>& job_window) {
+        std::map<std::pair<std::string, std::string>, std::vector<size_t>> groups;
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            if (results[i].error.empty()) groups[{ jobs[i].symbol, intervals[i] }].push_back(i);
+        }
+
+        std::vector<Window> windows;
+        for (auto& group : groups) {
+            // Неизвестный интервал кэш свечей не выравнивает - границы берём как есть
+            long long step = std::max(1LL, TimeUtils::interval_seconds(group.first.second));
+            std::vector<size_t>& members = group.second;
+            std::sort(members.begin(), members.end(), [&jobs](size_t a, size_t b) { return jobs[a].start < jobs[b].start; });
+            for (size_t i : members) {
+                long long start = TimeUtils::align_down(jobs[i].start, step);
+                bool joins = !windows.empty() && windows.back().symbol == group.first.first &&
+                    windows.back().interval == group.first.second && start <= windows.back().end + step;
+                if (!joins) {
+                    windows.push_back({ group.first.first, group.first.second, step, start, jobs[i].end, CandleSeries(), {} });
+                }
+                windows.back().end = std::max(windows.back().end, jobs[i].end);
+                job_window[i] = windows.size() - 1;
+            }
+        }
+        return windows;
+    }
+
+    static BacktestAggregate aggregate(const std::vector<BacktestJob>& jobs, const std::vector<BacktestJobResult>& results,
+        const std::string* symbol) {
+        BacktestAggregate total{};
+        std::vector<double> returns;
+        size_t profitable = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            if (symbol != nullptr && jobs[i].symbol != *symbol) continue;
+            const BacktestJobResult& result = results[i];
+            if (!result.ok) {
+                ++total.failed;
+                continue;
+            }
+            returns.push_back(result.summary.return_percent);
+            if (result.summary.pnl > 0) ++profitable;
+            total.mean_max_drawdown += result.summary.max_drawdown;
+            total.worst_max_drawdown = std::max(total.worst_max_drawdown, result.summary.max_drawdown);
+            total.trades += result.summary.trades;
+            total.winning_trades += result.summary.winning_trades;
+        }
+        total.jobs = returns.size();
+        if (returns.empty()) return total;
+
+        double count = static_cast<double>(returns.size());
+        double sum = 0;
+        for (double value : returns) sum += value;
+        total.mean_return = sum / count;
+        double squares = 0;
+        for (double value : returns) squares += (value - total.mean_return) * (value - total.mean_return);
+        total.stdev_return = std::sqrt(squares / count);
+        std::sort(returns.begin(), returns.end());
+        total.min_return = returns.front();
+        total.max_return = returns.back();
+        size_t middle = returns.size() / 2;
+        total.median_return = returns.size() % 2 ? returns[middle] : (returns[middle - 1] + returns[middle]) / 2;
+        total.profitable_share = profitable / count;
+        total.mean_max_drawdown /= count;
+        return total;
+    }
+
+    static std::string text(const nlohmann::json& value) {
+        return value.is_string() ? value.get<std::string>() : value.dump();
+    }
+
+    static std::string value_of(const std::map<std::string, std::string>& params, const std::string& name) {
+        auto it = params.find(name);
+        if (it == params.end()) {
+            throw std::invalid_argument("Missing " + name + " for a backtest job");
+        }
+        return it->second;
+    }
+
+    // Секунды от эпохи числом или строкой
+    static long long seconds(const nlohmann::json& value, const std::string& name) {
+        if (value.is_number_integer()) return value.get<long long>();
+        return seconds(text(value), name);
+    }
+
+    static long long seconds(const std::string& value, const std::string& name) {
+        try {
+            size_t pos = 0;
+            long long result = std::stoll(value, &pos);
+            if (pos == value.size()) return result;
+        }
+        catch (const std::exception&) {
+        }
+        throw std::invalid_argument(name + ": expected seconds since epoch, got '" + value + "'");
+    }
+
+    // Значения параметров задания - как в strategy_parameters запроса: нестроковые хранятся JSON-записью
+    static void merge_params(const nlohmann::json& overrides, std::map<std::string, std::string>& params) {
+        if (!overrides.is_object()) {
+            throw std::invalid_argument("Job strategy_parameters must be an object");
+        }
+        for (auto it = overrides.begin(); it != overrides.end(); ++it) {
+            params[it.key()] = text(it.value());
+        }
+    }
+};
+
+#endif // BATCH_BACKTEST_HPP
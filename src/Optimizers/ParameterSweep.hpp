@@ -0,0 +1,199 @@
+#ifndef PARAMETER_SWEEP_HPP
+#define PARAMETER_SWEEP_HPP
+
+#include "../StrategyFactory.hpp"
+#include "../TradeBots/TradeBot.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "../struct.hpp"
+#include "../Utils/Logger.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Сетка значений параметров стратегии: декартово произведение списков значений
+class ParameterGrid {
+public:
+    static constexpr size_t max_combinations = 100000;
+
+    void add_values(const std::string& name, std::vector<std::string> values) {
+        if (values.empty()) {
+            throw std::invalid_argument("Empty value list for parameter " + name);
+        }
+        axes_.push_back({ name, std::move(values) });
+        check_size();
+    }
+
+    void add_range(const std::string& name, double from, double to, double step) {
+        if (step <= 0 || to < from) {
+            throw std::invalid_argument("Invalid range for parameter " + name);
+        }
+        std::vector<std::string> values;
+        size_t steps = static_cast<size_t>(std::floor((to - from) / step + 1e-9)) + 1;
+        if (steps > max_combinations) {
+            throw std::invalid_argument("Too many values for parameter " + name);
+        }
+        for (size_t i = 0; i < steps; ++i) {
+            values.push_back(format_number(from + step * i));
+        }
+        add_values(name, std::move(values));
+    }
+
+    // Сетка из JSON: {"ma_length": [10, 20, 30], "rsi_period": {"from": 7, "to": 21, "step": 7}}
+    static ParameterGrid from_json(const nlohmann::json& grid_json) {
+        if (!grid_json.is_object() || grid_json.empty()) {
+            throw std::invalid_argument("parameter_grid must be a non-empty object");
+        }
+        ParameterGrid grid;
+        for (auto it = grid_json.begin(); it != grid_json.end(); ++it) {
+            const auto& value = it.value();
+            if (value.is_array()) {
+                std::vector<std::string> values;
+                for (const auto& item : value) {
+                    values.push_back(item.is_string() ? item.get<std::string>() : item.dump());
+                }
+                grid.add_values(it.key(), std::move(values));
+            }
+            else if (value.is_object()) {
+                grid.add_range(it.key(), value.at("from").get<double>(), value.at("to").get<double>(),
+                    value.value("step", 1.0));
+            }
+            else {
+                throw std::invalid_argument("Parameter " + it.key() + " must be a list or a range");
+            }
+        }
+        return grid;
+    }
+
+    size_t size() const {
+        size_t total = axes_.empty() ? 0 : 1;
+        for (const auto& axis : axes_) total *= axis.values.size();
+        return total;
+    }
+
+    // Параметры комбинации с номером index поверх базовых параметров
+    std::map<std::string, std::string> combination(size_t index, const std::map<std::string, std::string>& base) const {
+        std::map<std::string, std::string> params = base;
+        for (auto it = axes_.rbegin(); it != axes_.rend(); ++it) {
+            params[it->name] = it->values[index % it->values.size()];
+            index /= it->values.size();
+        }
+        return params;
+    }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> result;
+        for (const auto& axis : axes_) result.push_back(axis.name);
+        return result;
+    }
+
+private:
+    struct Axis {
+        std::string name;
+        std::vector<std::string> values;
+    };
+
+    std::vector<Axis> axes_;
+
+    void check_size() const {
+        size_t total = 1;
+        for (const auto& axis : axes_) {
+            total *= axis.values.size();
+            if (total > max_combinations) {
+                throw std::invalid_argument("Too many parameter combinations (max " + std::to_string(max_combinations) + ")");
+            }
+        }
+    }
+
+    static std::string format_number(double value) {
+        double rounded = std::round(value);
+        if (std::abs(value - rounded) < 1e-9) {
+            return std::to_string(static_cast<long long>(rounded));
+        }
+        std::ostringstream out;
+        out.precision(10);
+        out << value;
+        return out.str();
+    }
+};
+
+// Результат одной комбинации параметров
+struct SweepResult {
+    std::map<std::string, std::string> params;
+    BacktestSummary summary;
+    bool ok;
+    std::string error;
+};
+
+// Перебор параметров стратегии: свечи загружаются один раз, комбинации считаются параллельно
+class ParameterSweep {
+public:
+    static std::vector<SweepResult> run(
+        int user_id,
+        int strategy_id,
+        int broker_id,
+        const std::map<std::string, std::string>& base_params,
+        const ParameterGrid& grid,
+        const std::string& sort_by,
+        size_t top
+    ) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        const StrategyFactory& factory = StrategyFactory::getInstance();
+
+        // Первый бот создаётся обычным путём: он определяет информер и комиссии брокера
+        std::unique_ptr<TradeBot> prototype = factory.createStrategy(strategy_id, user_id, -1, broker_id, base_params);
+        BacktestResources resources{ prototype->get_informer(), prototype->get_broker() };
+        const CandleSeries candles = prototype->load_historical_candles();
+
+        std::vector<SweepResult> results(grid.size());
+        ThreadPool::shared().parallel_for(results.size(), [&](size_t i) {
+            SweepResult& result = results[i];
+            result.params = grid.combination(i, base_params);
+            try {
+                BacktestResources::Scope scope(resources);
+                std::unique_ptr<TradeBot> bot = factory.createStrategy(strategy_id, user_id, -1, broker_id, result.params);
+                result.summary = bot->execute_historical_summary(candles);
+                result.ok = true;
+            }
+            catch (const std::exception& e) {
+                result.ok = false;
+                result.error = e.what();
+            }
+            });
+
+        rank(results, sort_by);
+        if (top > 0 && results.size() > top) {
+            results.resize(top);
+        }
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start_time).count();
+        log_info() << "Parameter sweep: " << grid.size() << " combinations over " << candles.size()
+            << " candles in " << duration << " milliseconds";
+        return results;
+    }
+
+private:
+    // Сортировка по метрике; неудачные комбинации в конце
+    static void rank(std::vector<SweepResult>& results, const std::string& sort_by) {
+        auto metric = [&sort_by](const BacktestSummary& s) {
+            if (sort_by == "return_percent") return s.return_percent;
+            if (sort_by == "max_drawdown") return -s.max_drawdown;
+            if (sort_by == "trades") return static_cast<double>(s.trades);
+            return s.pnl;
+        };
+        std::stable_sort(results.begin(), results.end(), [&metric](const SweepResult& a, const SweepResult& b) {
+            if (a.ok != b.ok) return a.ok;
+            if (!a.ok) return false;
+            return metric(a.summary) > metric(b.summary);
+            });
+    }
+};
+
+#endif // PARAMETER_SWEEP_HPP
@@ -0,0 +1,238 @@
+#ifndef BOT_SCHEDULER_HPP
+#define BOT_SCHEDULER_HPP
+
+#include "../TradeBots/TradeBot.hpp"
+#include "../Informers/QuoteService.hpp"
+#include "../Utils/ThreadPool.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "../Utils/Logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// Планировщик ботов: один поток таймера и фиксированный пул исполнителей вместо потока на бота.
+// Боты с одинаковыми (рынок, символ, интервал) объединяются в группу,
+// группа просыпается на границе интервала, и одна цена идёт всем её ботам.
+class BotScheduler {
+public:
+    explicit BotScheduler(unsigned int workers = std::thread::hardware_concurrency())
+        : pool_(workers), timer_([this]() { timer_loop(); }) {
+    }
+
+    ~BotScheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        timer_.join();
+    }
+
+    BotScheduler(const BotScheduler&) = delete;
+    BotScheduler& operator=(const BotScheduler&) = delete;
+
+    // Добавляет бота: первый шаг выполняется сразу, следующие - на границах интервала
+    bool add(const std::shared_ptr<TradeBot>& bot) {
+        if (!bot->activate()) {
+            log_error().bot(bot->get_bot_id()).strategy(bot->get_strategy_id()).symbol(bot->get_symbol()) << "Bot " << bot->get_bot_id() << " has no database connection or informer.";
+            return false;
+        }
+        auto entry = std::make_shared<Entry>();
+        entry->bot = bot;
+        entry->log_fields.bot_id = bot->get_bot_id();
+        entry->log_fields.strategy_id = bot->get_strategy_id();
+        entry->log_fields.set_symbol(bot->get_symbol());
+
+        std::string key = group_key(*bot);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            remove_locked(bot->get_bot_id());
+
+            auto it = groups_.find(key);
+            if (it == groups_.end()) {
+                auto group = std::make_shared<Group>();
+                group->key = key;
+                group->step = step_seconds(bot->get_interval());
+                group->next_wake = next_boundary(group->step);
+                group->generation = ++last_generation_;
+                it = groups_.emplace(key, group).first;
+                timers_.push({ group->next_wake, key, group->generation });
+            }
+            it->second->bots[bot->get_bot_id()] = entry;
+            bot_groups_[bot->get_bot_id()] = key;
+        }
+        wake_.notify_all();
+
+        pool_.submit([entry]() { run_tick(entry, nullptr); });
+        return true;
+    }
+
+    // Снимает бота с расписания; выполняющийся шаг завершится, новые не начнутся
+    bool remove(int bot_id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return remove_locked(bot_id);
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return bot_groups_.size();
+    }
+
+private:
+    struct Entry {
+        std::shared_ptr<TradeBot> bot;
+        std::atomic<bool> busy{ false }; // не запускаем шаг, пока не закончился предыдущий
+        LogFields log_fields;            // поля записей журнала во время шага бота
+    };
+
+    struct Group {
+        std::string key;
+        long long step = 0;
+        long long next_wake = 0;
+        unsigned long long generation = 0;
+        std::map<int, std::shared_ptr<Entry>> bots;
+    };
+
+    struct Timer {
+        long long wake_at;
+        std::string key;
+        unsigned long long generation;
+        bool operator>(const Timer& other) const { return wake_at > other.wake_at; }
+    };
+
+    ThreadPool pool_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    unsigned long long last_generation_ = 0;
+    std::unordered_map<std::string, std::shared_ptr<Group>> groups_;
+    std::unordered_map<int, std::string> bot_groups_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers_;
+    ShardedHistogram& lag_ = Metrics::scheduler_lag(); // фактическое пробуждение таймера относительно границы интервала
+    std::thread timer_;
+
+    static std::string group_key(const TradeBot& bot) {
+        const Informer& informer = *bot.get_informer();
+        // Портфели - отдельно от ботов одного символа: цену группы они не берут
+        return std::string(bot.single_symbol() ? "" : "portfolio|") + typeid(informer).name() + "|" + bot.get_symbol() + "|" + bot.get_interval();
+    }
+
+    // Неизвестный интервал - раз в секунду, как раньше в TradeBot::get_sleep_duration
+    static long long step_seconds(const std::string& interval) {
+        long long step = TimeUtils::interval_seconds(interval);
+        return step > 0 ? step : 1;
+    }
+
+    static long long next_boundary(long long step) {
+        return TimeUtils::align_down(TimeUtils::now_seconds(), step) + step;
+    }
+
+    bool remove_locked(int bot_id) {
+        auto it = bot_groups_.find(bot_id);
+        if (it == bot_groups_.end()) return false;
+
+        auto group_it = groups_.find(it->second);
+        if (group_it != groups_.end()) {
+            group_it->second->bots.erase(bot_id);
+            if (group_it->second->bots.empty()) {
+                // Таймер удалённой группы отбрасывается по номеру поколения
+                groups_.erase(group_it);
+            }
+        }
+        bot_groups_.erase(it);
+        return true;
+    }
+
+    void timer_loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (timers_.empty()) {
+                wake_.wait(lock);
+                continue;
+            }
+            auto wake_at = std::chrono::system_clock::time_point(std::chrono::seconds(timers_.top().wake_at));
+            if (wake_.wait_until(lock, wake_at) != std::cv_status::timeout && !stopping_) {
+                continue; // добавили более ранний таймер или нас остановили
+            }
+            long long now = TimeUtils::now_seconds();
+            auto woke = std::chrono::system_clock::now();
+            while (!timers_.empty() && timers_.top().wake_at <= now) {
+                Timer timer = timers_.top();
+                timers_.pop();
+
+                auto it = groups_.find(timer.key);
+                if (it == groups_.end() || it->second->generation != timer.generation) continue;
+                // Опоздание считаем только для действующих таймеров: отброшенные шагов не запускают
+                lag_.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    woke - std::chrono::system_clock::time_point(std::chrono::seconds(timer.wake_at))));
+                Group& group = *it->second;
+
+                std::vector<std::shared_ptr<Entry>> entries;
+                entries.reserve(group.bots.size());
+                for (const auto& bot : group.bots) entries.push_back(bot.second);
+                dispatch(std::move(entries));
+
+                // Если отстали больше чем на интервал, пропущенные шаги не догоняем
+                group.next_wake = std::max(group.next_wake + group.step, next_boundary(group.step));
+                timers_.push({ group.next_wake, group.key, group.generation });
+            }
+        }
+    }
+
+    // Одна цена на группу, затем шаги ботов параллельно в пуле
+    void dispatch(std::vector<std::shared_ptr<Entry>> entries) {
+        pool_.submit([this, entries = std::move(entries)]() {
+            if (entries.empty()) return;
+            if (!entries.front()->bot->single_symbol()) {
+                // Портфель получает цены своих символов сам, одной пачкой
+                for (const auto& entry : entries) {
+                    pool_.submit([entry]() { run_tick(entry, nullptr); });
+                }
+                return;
+            }
+            double price;
+            try {
+                // Группы с разными интервалами на одном символе просыпаются одновременно - цену делит QuoteService
+                price = QuoteService::getInstance().get_symbol_now(
+                    entries.front()->bot->get_informer(), entries.front()->bot->get_symbol());
+            }
+            catch (const std::exception& e) {
+                log_error().symbol(entries.front()->bot->get_symbol()) << "Error fetching price for " << entries.front()->bot->get_symbol() << ": " << e.what();
+                return;
+            }
+            auto shared_price = std::make_shared<double>(price);
+            for (const auto& entry : entries) {
+                pool_.submit([entry, shared_price]() { run_tick(entry, shared_price.get()); });
+            }
+            });
+    }
+
+    static void run_tick(const std::shared_ptr<Entry>& entry, const double* price) {
+        LogContext::Scope log_scope(entry->log_fields);
+        if (entry->busy.exchange(true)) {
+            log_warn() << "Bot " << entry->bot->get_bot_id() << " skipped a tick: previous one is still running.";
+            return;
+        }
+        try {
+            if (price != nullptr) entry->bot->tick(*price);
+            else entry->bot->tick();
+        }
+        catch (const std::exception& e) {
+            log_error() << "Error in bot " << entry->bot->get_bot_id() << " tick: " << e.what();
+        }
+        entry->busy.store(false);
+    }
+};
+
+#endif // BOT_SCHEDULER_HPP
@@ -0,0 +1,151 @@
+#ifndef CHUNKED_WRITER_HPP
+#define CHUNKED_WRITER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// Очередь частей тела ответа между обработчиком (пишет в рабочем потоке) и сессией (отправляет на своём strand).
+// Мелкие записи копятся до chunk_size; если клиент не успевает читать и в очереди max_queued_chunks частей,
+// обработчик ждёт - память на соединение ограничена, а первые байты уходят, пока ответ ещё считается.
+// Ждать клиента обработчик может только до срока max_duration от начала ответа: медленный клиент
+// не должен занимать поток пула, поэтому после срока ответ обрывается.
+class ChunkedWriter {
+public:
+    static constexpr size_t chunk_size = 64 * 1024;
+    static constexpr size_t max_queued_chunks = 4;
+    static constexpr std::chrono::seconds max_duration{ 300 };
+
+    // Что сессии делать дальше
+    enum class State { Chunk, Empty, Finished, Aborted };
+
+    // on_ready вызывается, когда в очереди появилась часть или ответ закончен
+    explicit ChunkedWriter(std::function<void()> on_ready,
+        std::chrono::steady_clock::duration timeout = max_duration)
+        : on_ready_(std::move(on_ready)), deadline_(std::chrono::steady_clock::now() + timeout) {
+        buffer_.reserve(chunk_size);
+    }
+
+    // false - соединение оборвалось, продолжать нет смысла
+    bool write(const char* data, size_t size) {
+        buffer_.append(data, size);
+        if (buffer_.size() >= chunk_size) {
+            return flush();
+        }
+        return !failed();
+    }
+
+    bool write(const std::string& data) { return write(data.data(), data.size()); }
+
+    // Отправляет накопленное, не дожидаясь заполнения части
+    bool flush() {
+        if (buffer_.empty()) return !failed();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!space_.wait_until(lock, deadline_, [this]() { return failed_ || queue_.size() < max_queued_chunks; })) {
+                // Клиент не забрал ответ к сроку: сессия закроет соединение
+                expired_ = true;
+                failed_ = true;
+                queue_.clear();
+                lock.unlock();
+                on_ready_();
+                return false;
+            }
+            if (failed_) return false;
+            queue_.push_back(std::move(buffer_));
+        }
+        buffer_ = std::string();
+        buffer_.reserve(chunk_size);
+        on_ready_();
+        return true;
+    }
+
+    // Тело полностью записано
+    void finish() {
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            finished_ = true;
+        }
+        on_ready_();
+    }
+
+    // Ошибка после отправки заголовков: статус уже не поменять, поэтому соединение закрывается
+    // без завершающей части, и клиент видит обрыв, а не "успешный" обрезанный ответ
+    void abort() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            aborted_ = true;
+        }
+        on_ready_();
+    }
+
+    bool failed() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return failed_;
+    }
+
+    // Обработчик бросил ответ по сроку
+    bool expired() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return expired_;
+    }
+
+    // Сторона сессии: следующая часть для отправки
+    State next(std::string& chunk) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (failed_ || aborted_) return State::Aborted;
+        if (!queue_.empty()) {
+            chunk = std::move(queue_.front());
+            queue_.pop_front();
+            space_.notify_all();
+            return State::Chunk;
+        }
+        return finished_ ? State::Finished : State::Empty;
+    }
+
+    // Сторона сессии: запись в сокет не удалась, будим ждущий обработчик
+    void fail() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            failed_ = true;
+            queue_.clear();
+        }
+        space_.notify_all();
+    }
+
+private:
+    std::function<void()> on_ready_;
+    std::chrono::steady_clock::time_point deadline_;
+    std::string buffer_; // заполняется только потоком обработчика
+
+    mutable std::mutex mutex_;
+    std::condition_variable space_;
+    std::deque<std::string> queue_;
+    bool finished_ = false;
+    bool aborted_ = false;
+    bool failed_ = false;
+    bool expired_ = false;
+};
+
+// Передаётся обработчику запроса: если он вызвал start, заголовки берутся из ответа,
+// а тело пишет producer в пуле обработчиков
+class ResponseStream {
+public:
+    using Producer = std::function<void(ChunkedWriter&)>;
+
+    void start(Producer producer) { producer_ = std::move(producer); }
+    bool started() const { return static_cast<bool>(producer_); }
+    void reset() { producer_ = nullptr; }
+    Producer take() { return std::move(producer_); }
+
+private:
+    Producer producer_;
+};
+
+#endif // CHUNKED_WRITER_HPP
@@ -0,0 +1,114 @@
+#ifndef COLUMNAR_WRITER_HPP
+#define COLUMNAR_WRITER_HPP
+
+#include "./ChunkedWriter.hpp"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "ColumnarWriter writes native arrays and expects a little-endian host"
+#endif
+
+// Двоичный столбцовый формат ответа (Content-Type: application/vnd.tradesnake.columnar).
+// Все числа little-endian, массивы выровнены на 8 байт от начала ответа.
+//
+// Заголовок, 8 байт:
+//   char[4] magic = "TSCB", uint16 version = 1, uint16 kind (1 - свечи, 2 - результат бэктеста)
+// Далее пачки по rows строк (не больше batch_rows):
+//   uint32 rows, uint32 events
+//   int64[rows] timestamp (мс), float64[rows] open, high, low, close, volume, turnover
+//   events записей по 32 байта: uint32 row (номер строки в пачке), uint32 side (1 - покупка, 2 - продажа),
+//   float64 price, float64 broker_price, float64 quantity
+// Пачка с rows = 0 и events = 0 - конец ответа; без неё ответ считается оборванным.
+class ColumnarWriter {
+public:
+    static constexpr const char* content_type = "application/vnd.tradesnake.columnar";
+    static constexpr size_t batch_rows = 8192;
+
+    enum class Kind : uint16_t { Candles = 1, Backtest = 2 };
+    enum class Side : uint32_t { Buy = 1, Sell = 2 };
+
+    ColumnarWriter(ChunkedWriter& out, Kind kind) : out_(out) {
+        char header[8] = { 'T', 'S', 'C', 'B' };
+        uint16_t version = 1;
+        uint16_t kind_value = static_cast<uint16_t>(kind);
+        std::memcpy(header + 4, &version, sizeof(version));
+        std::memcpy(header + 6, &kind_value, sizeof(kind_value));
+        write(header, sizeof(header));
+
+        timestamps_.reserve(batch_rows);
+        for (auto& column : columns_) column.reserve(batch_rows);
+    }
+
+    void add_row(int64_t timestamp, double open, double high, double low, double close, double volume, double turnover) {
+        if (timestamps_.size() == batch_rows) {
+            flush_batch();
+        }
+        timestamps_.push_back(timestamp);
+        columns_[0].push_back(open);
+        columns_[1].push_back(high);
+        columns_[2].push_back(low);
+        columns_[3].push_back(close);
+        columns_[4].push_back(volume);
+        columns_[5].push_back(turnover);
+    }
+
+    // Сделка на последней добавленной строке
+    void add_event(Side side, double price, double broker_price, double quantity) {
+        if (timestamps_.empty()) {
+            throw std::logic_error("Columnar event without a row");
+        }
+        events_.push_back({ static_cast<uint32_t>(timestamps_.size() - 1), static_cast<uint32_t>(side),
+            price, broker_price, quantity });
+    }
+
+    // Дописывает последнюю пачку и маркер конца
+    void finish() {
+        flush_batch();
+        uint32_t end[2] = { 0, 0 };
+        write(end, sizeof(end));
+    }
+
+private:
+    struct Event {
+        uint32_t row;
+        uint32_t side;
+        double price;
+        double broker_price;
+        double quantity;
+    };
+    static_assert(sizeof(Event) == 32, "Columnar event must be 32 bytes");
+
+    ChunkedWriter& out_;
+    std::vector<int64_t> timestamps_;
+    std::vector<double> columns_[6]; // open, high, low, close, volume, turnover
+    std::vector<Event> events_;
+
+    void flush_batch() {
+        if (timestamps_.empty()) return;
+        uint32_t counts[2] = { static_cast<uint32_t>(timestamps_.size()), static_cast<uint32_t>(events_.size()) };
+        write(counts, sizeof(counts));
+        write(timestamps_.data(), timestamps_.size() * sizeof(int64_t));
+        for (auto& column : columns_) {
+            write(column.data(), column.size() * sizeof(double));
+            column.clear();
+        }
+        if (!events_.empty()) {
+            write(events_.data(), events_.size() * sizeof(Event));
+        }
+        timestamps_.clear();
+        events_.clear();
+    }
+
+    // Клиент отключился - прерываем расчёт, как и при выдаче JSON
+    void write(const void* data, size_t size) {
+        if (!out_.write(static_cast<const char*>(data), size)) {
+            throw std::runtime_error("client disconnected");
+        }
+    }
+};
+
+#endif // COLUMNAR_WRITER_HPP
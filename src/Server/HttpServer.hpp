@@ -0,0 +1,362 @@
+#ifndef HTTP_SERVER_HPP
+#define HTTP_SERVER_HPP
+
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/strand.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+#include "./ChunkedWriter.hpp"
+#include "../Utils/Logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+
+namespace beast = boost::beast;
+namespace http = boost::beast::http;
+namespace net = boost::asio;
+using tcp = boost::asio::ip::tcp;
+
+// Обработчик запроса: заполняет ответ по запросу и адресу клиента;
+// большое тело вместо res.body() можно отдать частями через ResponseStream
+using RequestHandler = std::function<void(
+    http::request<http::string_body>&,
+    http::response<http::string_body>&,
+    const tcp::endpoint&,
+    ResponseStream&)>;
+
+// Признак "тяжёлого" маршрута, который нельзя выполнять на потоке ввода-вывода
+using RouteClassifier = std::function<bool(const http::request<http::string_body>&)>;
+
+// Ограничение числа одновременных потоковых ответов: каждый занимает поток пула обработчиков,
+// пока клиент не дочитает ответ, поэтому их должно быть меньше, чем потоков пула
+class StreamLimit {
+public:
+    explicit StreamLimit(size_t max_streams) : max_(max_streams) {}
+
+    bool try_acquire() {
+        size_t active = active_.load();
+        while (active < max_) {
+            if (active_.compare_exchange_weak(active, active + 1)) return true;
+        }
+        return false;
+    }
+
+    void release() { active_.fetch_sub(1); }
+
+private:
+    const size_t max_;
+    std::atomic<size_t> active_{ 0 };
+};
+
+// Сессия одного соединения: чтение запроса, обработка, запись ответа, keep-alive
+class HttpSession : public std::enable_shared_from_this<HttpSession> {
+public:
+    HttpSession(tcp::socket&& socket, RequestHandler& handler, RouteClassifier& is_heavy, net::thread_pool& workers,
+        StreamLimit& streams)
+        : stream_(std::move(socket)), handler_(handler), is_heavy_(is_heavy), workers_(workers), streams_(streams) {
+    }
+
+    ~HttpSession() {
+        if (stream_slot_) streams_.release();
+    }
+
+    void run() {
+        beast::error_code ec;
+        client_endpoint_ = stream_.socket().remote_endpoint(ec);
+        // Все операции сессии выполняются на её strand
+        net::dispatch(stream_.get_executor(),
+            beast::bind_front_handler(&HttpSession::do_read, shared_from_this()));
+    }
+
+private:
+    static constexpr std::chrono::seconds read_timeout{ 30 };
+    static constexpr std::chrono::seconds write_timeout{ 120 };
+
+    beast::tcp_stream stream_;
+    beast::flat_buffer buffer_;
+    http::request<http::string_body> req_;
+    tcp::endpoint client_endpoint_;
+    RequestHandler& handler_;
+    RouteClassifier& is_heavy_;
+    net::thread_pool& workers_;
+    StreamLimit& streams_;
+
+    // Состояние потоковой отдачи; меняется только на strand сессии
+    std::shared_ptr<ChunkedWriter> writer_;
+    bool header_sent_ = false;
+    bool chunk_in_flight_ = false;
+    bool stream_close_ = false;
+    bool stream_slot_ = false; // занято место в StreamLimit
+
+    void do_read() {
+        req_ = {};
+        stream_.expires_after(read_timeout);
+        http::async_read(stream_, buffer_, req_,
+            beast::bind_front_handler(&HttpSession::on_read, shared_from_this()));
+    }
+
+    void on_read(beast::error_code ec, std::size_t) {
+        if (ec == http::error::end_of_stream) {
+            return do_close();
+        }
+        if (ec) {
+            if (ec != beast::error::timeout && ec != net::error::operation_aborted) {
+                log_warn() << "HTTP read error: " << ec.message();
+            }
+            return;
+        }
+
+        if (!is_heavy_(req_)) {
+            // Управляющие запросы (/stop и т.п.) обрабатываем сразу на потоке ввода-вывода
+            auto stream = std::make_shared<ResponseStream>();
+            respond(handle(*stream), stream);
+            return;
+        }
+
+        // Бэктесты и запросы к биржам уходят в пул обработчиков, чтобы не блокировать остальных клиентов
+        stream_.expires_never();
+        net::post(workers_, [self = shared_from_this()]() {
+            auto stream = std::make_shared<ResponseStream>();
+            auto res = self->handle(*stream);
+            net::post(self->stream_.get_executor(), [self, res, stream]() {
+                self->respond(res, stream);
+                });
+            });
+    }
+
+    std::shared_ptr<http::response<http::string_body>> handle(ResponseStream& stream) {
+        auto res = std::make_shared<http::response<http::string_body>>();
+        res->version(req_.version());
+        res->set(http::field::server, BOOST_BEAST_VERSION_STRING);
+        try {
+            handler_(req_, *res, client_endpoint_, stream);
+        }
+        catch (const std::exception& e) {
+            stream.reset();
+            res->result(http::status::internal_server_error);
+            res->set(http::field::content_type, "text/plain");
+            res->body() = "Error: " + std::string(e.what());
+        }
+        res->keep_alive(req_.keep_alive());
+        if (!stream.started()) {
+            res->prepare_payload();
+        }
+        return res;
+    }
+
+    void respond(std::shared_ptr<http::response<http::string_body>> res, const std::shared_ptr<ResponseStream>& stream) {
+        if (stream->started()) {
+            start_stream(*res, stream->take());
+        }
+        else {
+            do_write(res);
+        }
+    }
+
+    // Заголовки с Transfer-Encoding: chunked, затем части тела по мере того, как их пишет producer
+    void start_stream(http::response<http::string_body>& res, ResponseStream::Producer producer) {
+        if (!streams_.try_acquire()) {
+            // Заголовки ещё не отправлены, поэтому клиенту можно честно ответить "занято"
+            log_warn() << "Too many streaming responses, rejecting " << std::string(req_.target());
+            auto busy = std::make_shared<http::response<http::string_body>>(http::status::service_unavailable, req_.version());
+            busy->set(http::field::server, BOOST_BEAST_VERSION_STRING);
+            busy->set(http::field::content_type, "text/plain");
+            busy->set(http::field::retry_after, "1");
+            busy->keep_alive(req_.keep_alive());
+            busy->body() = "Error: too many streaming responses in progress, retry later";
+            busy->prepare_payload();
+            return do_write(busy);
+        }
+        stream_slot_ = true;
+
+        auto head = std::make_shared<http::response<http::empty_body>>(std::move(res.base()));
+        head->chunked(true);
+        stream_close_ = head->need_eof();
+        header_sent_ = false;
+        chunk_in_flight_ = false;
+
+        auto self = shared_from_this();
+        writer_ = std::make_shared<ChunkedWriter>([self]() {
+            net::post(self->stream_.get_executor(), [self]() { self->pump(); });
+            });
+
+        auto serializer = std::make_shared<http::response_serializer<http::empty_body>>(*head);
+        stream_.expires_after(write_timeout);
+        http::async_write_header(stream_, *serializer,
+            [self, head, serializer](beast::error_code ec, std::size_t) {
+                if (ec) {
+                    return self->fail_stream(ec);
+                }
+                self->header_sent_ = true;
+                self->pump();
+            });
+
+        net::post(workers_, [writer = writer_, producer = std::move(producer)]() {
+            try {
+                producer(*writer);
+                writer->finish();
+            }
+            catch (const std::exception& e) {
+                log_error() << "Error while streaming response: " << e.what();
+                writer->abort();
+            }
+            });
+    }
+
+    // Отправляет следующую готовую часть; вызывается после каждой записи и при появлении данных
+    void pump() {
+        if (!writer_) return;
+        if (writer_->expired()) {
+            // Обработчик уже бросил ответ, текущую запись не ждём
+            log_warn() << "HTTP stream to " << client_endpoint_.address().to_string() << " timed out: the client reads too slowly";
+            end_stream();
+            close_now();
+            return;
+        }
+        if (!header_sent_ || chunk_in_flight_) return;
+
+        auto chunk = std::make_shared<std::string>();
+        switch (writer_->next(*chunk)) {
+        case ChunkedWriter::State::Empty:
+            return;
+        case ChunkedWriter::State::Chunk:
+            chunk_in_flight_ = true;
+            stream_.expires_after(write_timeout);
+            net::async_write(stream_, http::make_chunk(net::buffer(*chunk)),
+                [self = shared_from_this(), chunk](beast::error_code ec, std::size_t) {
+                    self->chunk_in_flight_ = false;
+                    if (ec) {
+                        return self->fail_stream(ec);
+                    }
+                    self->pump();
+                });
+            return;
+        case ChunkedWriter::State::Finished:
+            chunk_in_flight_ = true;
+            stream_.expires_after(write_timeout);
+            net::async_write(stream_, http::make_chunk_last(),
+                [self = shared_from_this()](beast::error_code ec, std::size_t bytes) {
+                    self->chunk_in_flight_ = false;
+                    self->end_stream();
+                    self->on_write(self->stream_close_, ec, bytes);
+                });
+            return;
+        case ChunkedWriter::State::Aborted:
+            end_stream();
+            close_now();
+            return;
+        }
+    }
+
+    void fail_stream(beast::error_code ec) {
+        // operation_aborted - запись отменена нами же при закрытии соединения
+        if (ec != net::error::operation_aborted) {
+            log_error() << "HTTP stream write error: " << ec.message();
+        }
+        if (writer_) {
+            writer_->fail();
+        }
+        end_stream();
+        close_now();
+    }
+
+    // Поток закончен или оборван; место в StreamLimit освобождается до чтения следующего запроса
+    void end_stream() {
+        writer_.reset();
+        if (stream_slot_) {
+            stream_slot_ = false;
+            streams_.release();
+        }
+    }
+
+    void close_now() {
+        beast::error_code ec;
+        stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+        stream_.socket().close(ec);
+    }
+
+    void do_write(std::shared_ptr<http::response<http::string_body>> res) {
+        stream_.expires_after(write_timeout);
+        http::async_write(stream_, *res,
+            [self = shared_from_this(), res](beast::error_code ec, std::size_t bytes) {
+                self->on_write(res->need_eof(), ec, bytes);
+            });
+    }
+
+    void on_write(bool close, beast::error_code ec, std::size_t) {
+        if (ec) {
+            log_error() << "HTTP write error: " << ec.message();
+            return;
+        }
+        if (close) {
+            return do_close();
+        }
+        do_read();
+    }
+
+    void do_close() {
+        beast::error_code ec;
+        stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+    }
+};
+
+// Принимает входящие соединения и создаёт для каждого сессию
+class HttpListener : public std::enable_shared_from_this<HttpListener> {
+public:
+    // max_streams - сколько потоковых ответов может одновременно занимать пул обработчиков
+    HttpListener(net::io_context& ioc, const tcp::endpoint& endpoint, RequestHandler handler,
+        RouteClassifier is_heavy, net::thread_pool& workers, size_t max_streams)
+        : ioc_(ioc), acceptor_(net::make_strand(ioc)), handler_(std::move(handler)),
+        is_heavy_(std::move(is_heavy)), workers_(workers), streams_(max_streams) {
+        acceptor_.open(endpoint.protocol());
+        acceptor_.set_option(net::socket_base::reuse_address(true));
+        acceptor_.bind(endpoint);
+        acceptor_.listen(net::socket_base::max_listen_connections);
+    }
+
+    void run() {
+        do_accept();
+    }
+
+    // Фактический адрес (при порте 0 порт выбирает система)
+    tcp::endpoint local_endpoint() const {
+        return acceptor_.local_endpoint();
+    }
+
+private:
+    net::io_context& ioc_;
+    tcp::acceptor acceptor_;
+    RequestHandler handler_;
+    RouteClassifier is_heavy_;
+    net::thread_pool& workers_;
+    StreamLimit streams_;
+
+    void do_accept() {
+        // Каждое соединение получает собственный strand
+        acceptor_.async_accept(net::make_strand(ioc_),
+            beast::bind_front_handler(&HttpListener::on_accept, shared_from_this()));
+    }
+
+    void on_accept(beast::error_code ec, tcp::socket socket) {
+        if (ec == net::error::operation_aborted) {
+            return;
+        }
+        if (ec) {
+            log_error() << "Accept error: " << ec.message();
+        }
+        else {
+            std::make_shared<HttpSession>(std::move(socket), handler_, is_heavy_, workers_, streams_)->run();
+        }
+        do_accept();
+    }
+};
+
+#endif // HTTP_SERVER_HPP
@@ -0,0 +1,46 @@
+#ifndef REQUEST_ARENA_HPP
+#define REQUEST_ARENA_HPP
+
+#include <cstddef>
+#include <memory_resource>
+
+// Память одного HTTP-запроса: монотонный буфер, который освобождается целиком, когда запрос обработан.
+// Первый блок - буфер потока, поэтому типичный запрос вовсе не обращается к куче; больше initial_size
+// буфер растёт из обычной кучи. Пока объект жив, он - текущая арена потока (RequestArena::current()).
+class RequestArena {
+public:
+    static constexpr size_t initial_size = 16 * 1024;
+
+    RequestArena()
+        : previous_(current()),
+          // Вложенная арена на том же потоке не может делить буфер потока с внешней
+          resource_(previous_ == nullptr
+              ? std::pmr::monotonic_buffer_resource(thread_buffer(), initial_size, std::pmr::new_delete_resource())
+              : std::pmr::monotonic_buffer_resource(initial_size, std::pmr::new_delete_resource())) {
+        current() = this;
+    }
+
+    ~RequestArena() { current() = previous_; }
+
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &resource_; }
+
+    // Арена обрабатываемого на этом потоке запроса; nullptr вне запроса
+    static RequestArena*& current() {
+        thread_local RequestArena* arena = nullptr;
+        return arena;
+    }
+
+private:
+    RequestArena* previous_;
+    std::pmr::monotonic_buffer_resource resource_;
+
+    static void* thread_buffer() {
+        alignas(std::max_align_t) thread_local char buffer[initial_size];
+        return buffer;
+    }
+};
+
+#endif // REQUEST_ARENA_HPP
@@ -0,0 +1,129 @@
+#ifndef REQUEST_JSON_HPP
+#define REQUEST_JSON_HPP
+
+#include "../struct.hpp"
+#include "../Data/CandleSeries.hpp"
+#include "./RequestArena.hpp"
+#include "../Utils/Logger.hpp"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Параметры тела запроса без копирования строк: JSON разбирается один раз, ключи и строковые значения -
+// ссылки на разобранный документ, остальные значения записываются текстом (как json::dump) в арену запроса.
+// Вложенные объекты (strategy_parameters, parameter_grid) доступны через json_value без повторного разбора.
+// Ошибка разбора даёт пустой набор параметров.
+class RequestParams {
+public:
+    explicit RequestParams(const std::string& body)
+        : arena_(RequestArena::current() ? RequestArena::current()->resource() : &fallback_.emplace(1024)),
+          values_(arena_) {
+        try {
+            document_ = nlohmann::json::parse(body);
+        }
+        catch (const std::exception& e) {
+            log_error() << "JSON parsing error: " << e.what();
+            return;
+        }
+        if (!document_.is_object()) return;
+
+        for (auto it = document_.begin(); it != document_.end(); ++it) {
+            const nlohmann::json& value = it.value();
+            values_.emplace(std::string_view(it.key()), Value{ text_of(value), &value });
+        }
+    }
+
+    RequestParams(const RequestParams&) = delete;
+    RequestParams& operator=(const RequestParams&) = delete;
+
+    bool contains(std::string_view key) const { return values_.find(key) != values_.end(); }
+
+    // Значение строкой; пустая строка, если ключа нет. Ссылка живёт, пока жив объект
+    std::string_view operator[](std::string_view key) const {
+        auto it = values_.find(key);
+        return it == values_.end() ? std::string_view() : it->second.text;
+    }
+
+    // Как std::stoi от строкового значения
+    int get_int(std::string_view key) const { return std::stoi(std::string((*this)[key])); }
+
+    const nlohmann::json* json_value(std::string_view key) const {
+        auto it = values_.find(key);
+        return it == values_.end() ? nullptr : it->second.json;
+    }
+
+    // Параметры стратегии для бота: строки - как есть, остальное - текстом JSON. Объект можно передать
+    // и строкой с JSON, как раньше
+    std::map<std::string, std::string> strategy_params(std::string_view key = "strategy_parameters") const {
+        std::map<std::string, std::string> result;
+        const nlohmann::json* value = json_value(key);
+        if (value == nullptr) return result;
+        if (value->is_string()) {
+            copy_members(nlohmann::json::parse(value->get_ref<const std::string&>()), result);
+        }
+        else {
+            copy_members(*value, result);
+        }
+        return result;
+    }
+
+private:
+    struct Value {
+        std::string_view text;
+        const nlohmann::json* json;
+    };
+
+    std::optional<std::pmr::monotonic_buffer_resource> fallback_; // только вне RequestArena
+    std::pmr::memory_resource* arena_;
+    nlohmann::json document_;
+    std::pmr::map<std::string_view, Value, std::less<>> values_;
+
+    std::string_view text_of(const nlohmann::json& value) {
+        if (value.is_string()) return value.get_ref<const std::string&>();
+        std::string text = value.dump();
+        char* copy = static_cast<char*>(arena_->allocate(text.size() + 1, 1));
+        text.copy(copy, text.size());
+        copy[text.size()] = '\0';
+        return std::string_view(copy, text.size());
+    }
+
+    static void copy_members(const nlohmann::json& object, std::map<std::string, std::string>& out) {
+        if (!object.is_object()) return;
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            const nlohmann::json& value = it.value();
+            out[it.key()] = value.is_string() ? value.get<std::string>() : value.dump();
+        }
+    }
+};
+
+// Сделка в ответе /execute_historical; на свечах без сделки - пустой объект
+inline nlohmann::json trade_event_json(const TradeEvent* trade) {
+    if (!trade) return nlohmann::json::object();
+    return {
+        {"price", trade->price},
+        {"broker_price", trade->broker_price},
+        {"quantity", trade->quantity}
+    };
+}
+
+// Элемент JSON-ответа /execute_historical по одной свече (время - строкой в миллисекундах)
+inline nlohmann::json historical_candle_json(const CandleSeries& candles, size_t i, const TradeEvent* trade) {
+    return {
+        {"timestamp", std::to_string(candles.timestamp(i))},
+        {"open", candles.open()[i]},
+        {"close", candles.close()[i]},
+        {"high", candles.high()[i]},
+        {"low", candles.low()[i]},
+        {"volume", candles.volume()[i]},
+        {"turnover", candles.turnover()[i]},
+        {"buy", trade_event_json(trade && trade->side == 1 ? trade : nullptr)},
+        {"sell", trade_event_json(trade && trade->side == -1 ? trade : nullptr)}
+    };
+}
+
+#endif // REQUEST_JSON_HPP
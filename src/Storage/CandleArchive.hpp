@@ -0,0 +1,490 @@
+#ifndef CANDLE_ARCHIVE_HPP
+#define CANDLE_ARCHIVE_HPP
+
+#include "../Informers/Informer.hpp"
+#include "../Data/CandleSeries.hpp"
+#include "../Utils/MappedFile.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Span.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "../Utils/Logger.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <shared_mutex>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+// Счётчики архива свечей
+struct CandleArchiveStats {
+    uint64_t hits;             // запрос полностью обслужен из архива
+    uint64_t partial_hits;     // из информера догружены только края периода
+    uint64_t misses;           // ряда в архиве ещё не было
+    uint64_t bypassed;         // период не примыкает к архиву, запрос ушёл в информер напрямую
+    uint64_t fetched_candles;  // свечей загружено из информеров
+    uint64_t archived_candles; // свечей дописано в архив
+    size_t series;
+};
+
+// Архив закрытых свечей на диске по ключу (рынок, символ, интервал) - слой между кэшем свечей и информером.
+// Каталог ряда <root>/<рынок>/<символ>/<интервал> содержит header.bin (покрытый период и число свечей)
+// и по файлу на столбец: timestamp.i64, open.f64, high.f64, low.f64, close.f64, volume.f64, turnover.f64 -
+// массивы фиксированной ширины в порядке байт платформы. Свечи дописываются в конец файлов,
+// читаются из отображения в память. Покрытие ряда - один непрерывный период,
+// поэтому из информера догружаются не больше двух участков по краям.
+class CandleArchive {
+public:
+    static CandleArchive& getInstance() {
+        static CandleArchive instance;
+        return instance;
+    }
+
+    bool enabled() const { return !root_.empty(); }
+
+    // Упорядоченные свечи периода [start, end] (секунды от эпохи); незакрытые свечи берутся из информера и не сохраняются
+    CandleSeries get_symbol_historical(
+        const std::shared_ptr<Informer>& informer,
+        const std::string& symbol,
+        long long start,
+        long long end,
+        const std::string& interval
+    ) {
+        long long step = TimeUtils::interval_seconds(interval);
+        if (!enabled() || step == 0) {
+            return fetch(*informer, symbol, start, end, interval);
+        }
+        start = TimeUtils::align_down(start, step);
+        long long closed_end = std::min(end, last_closed(step) + step - 1);
+
+        std::shared_ptr<Entry> entry = acquire(make_key(*informer, symbol, interval));
+        CandleSeries result;
+        bool served = false;
+        if (start <= closed_end) {
+            {
+                std::shared_lock<std::shared_mutex> lock(entry->mutex);
+                if (covers(*entry, start, closed_end)) {
+                    hits_.fetch_add(1, std::memory_order_relaxed);
+                    read(*entry, start, closed_end, result);
+                    served = true;
+                }
+            }
+            if (!served) {
+                std::unique_lock<std::shared_mutex> lock(entry->mutex);
+                const Header& header = entry->header;
+                if (header.count == 0) {
+                    misses_.fetch_add(1, std::memory_order_relaxed);
+                    load(*entry, *informer, symbol, interval, start, closed_end);
+                    served = true;
+                }
+                else if (start <= header.covered_end + 1 && closed_end >= header.covered_start - 1) {
+                    // Догружаем только края, которых нет в архиве
+                    partial_hits_.fetch_add(1, std::memory_order_relaxed);
+                    if (start < header.covered_start) {
+                        load(*entry, *informer, symbol, interval, start, header.covered_start - 1);
+                    }
+                    if (closed_end > header.covered_end) {
+                        load(*entry, *informer, symbol, interval, header.covered_end + 1, closed_end);
+                    }
+                    served = true;
+                }
+                if (served) {
+                    read(*entry, start, closed_end, result);
+                }
+            }
+            if (!served) {
+                // Дальний период не склеить с архивом без загрузки промежутка - его дополняет только фоновая догрузка
+                bypassed_.fetch_add(1, std::memory_order_relaxed);
+                return fetch(*informer, symbol, start, end, interval);
+            }
+        }
+
+        if (end > closed_end) {
+            CandleSeries tail = fetch(*informer, symbol, std::max(start, closed_end + 1), end, interval);
+            result.append(tail, tail.lower_bound((closed_end + 1) * 1000), tail.size());
+        }
+        return result;
+    }
+
+    // Дописывает в архив не больше max_candles закрытых свечей в сторону периода [start, end].
+    // Возвращает число добавленных свечей; 0 - период уже покрыт или информер ничего не отдал
+    size_t extend(
+        const std::shared_ptr<Informer>& informer,
+        const std::string& symbol,
+        const std::string& interval,
+        long long start,
+        long long end,
+        size_t max_candles
+    ) {
+        long long step = TimeUtils::interval_seconds(interval);
+        if (!enabled() || step == 0 || max_candles == 0) return 0;
+        start = TimeUtils::align_down(start, step);
+        end = std::min(end, last_closed(step) + step - 1);
+        if (start > end) return 0;
+
+        std::shared_ptr<Entry> entry = acquire(make_key(*informer, symbol, interval));
+        std::unique_lock<std::shared_mutex> lock(entry->mutex);
+        const Header& header = entry->header;
+        long long span = static_cast<long long>(max_candles) * step;
+        if (header.count == 0) {
+            return load(*entry, *informer, symbol, interval, start, std::min(end, start + span - 1));
+        }
+        if (end > header.covered_end) {
+            long long from = header.covered_end + 1;
+            return load(*entry, *informer, symbol, interval, from, std::min(end, from + span - 1));
+        }
+        if (start < header.covered_start) {
+            long long to = header.covered_start - 1;
+            return load(*entry, *informer, symbol, interval, std::max(start, to - span + 1), to);
+        }
+        return 0;
+    }
+
+    // Покрытый архивом период ряда; false, если свечей в архиве нет
+    bool coverage(const Informer& informer, const std::string& symbol, const std::string& interval,
+        long long& start, long long& end) {
+        if (!enabled()) return false;
+        std::shared_ptr<Entry> entry = acquire(make_key(informer, symbol, interval));
+        std::shared_lock<std::shared_mutex> lock(entry->mutex);
+        if (entry->header.count == 0) return false;
+        start = entry->header.covered_start;
+        end = entry->header.covered_end;
+        return true;
+    }
+
+    CandleArchiveStats get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {
+            hits_.load(std::memory_order_relaxed),
+            partial_hits_.load(std::memory_order_relaxed),
+            misses_.load(std::memory_order_relaxed),
+            bypassed_.load(std::memory_order_relaxed),
+            fetched_candles_.load(std::memory_order_relaxed),
+            archived_candles_.load(std::memory_order_relaxed),
+            entries_.size()
+        };
+    }
+
+private:
+    static constexpr size_t column_count = 7; // timestamp, open, high, low, close, volume, turnover
+    static constexpr uint32_t format_version = 1;
+
+    // header.bin; count == 0 - ряд пуст (или его перезапись не завершилась)
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        int64_t covered_start; // секунды, границы включительно
+        int64_t covered_end;
+        uint64_t count;
+    };
+    static_assert(sizeof(Header) == 32, "Archive header must be 32 bytes");
+    static_assert(sizeof(double) == sizeof(int64_t), "Archive columns must have the same width");
+
+    struct Entry {
+        std::shared_mutex mutex; // чтение - общая блокировка, запись - исключительная
+        std::filesystem::path dir;
+        Header header{};
+        std::array<MappedFile, column_count> columns;
+    };
+
+    std::filesystem::path root_;
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, std::shared_ptr<Entry>> entries_;
+
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> partial_hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+    std::atomic<uint64_t> bypassed_{ 0 };
+    std::atomic<uint64_t> fetched_candles_{ 0 };
+    std::atomic<uint64_t> archived_candles_{ 0 };
+
+    CandleArchive() {
+        const char* value = std::getenv("TRADESNAKE_CANDLE_ARCHIVE_DIR");
+        std::string dir = value != nullptr ? value : "candle_archive";
+        if (dir != "off") {
+            root_ = dir;
+        }
+    }
+
+    CandleArchive(const CandleArchive&) = delete;
+    CandleArchive& operator=(const CandleArchive&) = delete;
+
+    static const char* column_name(size_t index) {
+        static const char* names[column_count] = {
+            "timestamp.i64", "open.f64", "high.f64", "low.f64", "close.f64", "volume.f64", "turnover.f64"
+        };
+        return names[index];
+    }
+
+    static long long last_closed(long long step) {
+        return TimeUtils::align_down(TimeUtils::now_seconds(), step) - step;
+    }
+
+    // Имя каталога без разделителей пути и прочих спецсимволов
+    static std::string sanitize(const std::string& value) {
+        std::string result;
+        for (char c : value) {
+            bool safe = std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.';
+            result += safe ? c : '_';
+        }
+        return result.empty() || result == "." || result == ".." ? "_" + result : result;
+    }
+
+    // Рынок определяется типом информера, как и в кэше свечей; имя типа без префиксов компилятора
+    static std::string market_name(const Informer& informer) {
+        std::string name = typeid(informer).name();
+        for (const char* prefix : { "class ", "struct " }) {
+            if (name.compare(0, std::strlen(prefix), prefix) == 0) name.erase(0, std::strlen(prefix));
+        }
+        size_t digits = 0;
+        while (digits < name.size() && std::isdigit(static_cast<unsigned char>(name[digits]))) ++digits;
+        return sanitize(name.substr(digits));
+    }
+
+    static std::string make_key(const Informer& informer, const std::string& symbol, const std::string& interval) {
+        return market_name(informer) + "/" + sanitize(symbol) + "/" + sanitize(interval);
+    }
+
+    std::shared_ptr<Entry> acquire(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(key);
+        if (it != entries_.end()) return it->second;
+
+        auto entry = std::make_shared<Entry>();
+        entry->dir = root_ / std::filesystem::path(key);
+        open_entry(*entry);
+        entries_[key] = entry;
+        return entry;
+    }
+
+    // Чтение заголовка и отображение столбцов; повреждённый ряд считается пустым и будет загружен заново
+    static void open_entry(Entry& entry) {
+        entry.header = Header{};
+        for (auto& column : entry.columns) column.close();
+
+        std::ifstream file(entry.dir / "header.bin", std::ios::binary);
+        if (!file) return;
+        Header header{};
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, "TSCA", 4) != 0 || header.version != format_version) {
+            log_warn() << "Ignoring invalid candle archive header in " << entry.dir.string();
+            return;
+        }
+        for (size_t i = 0; i < column_count && header.count != 0; ++i) {
+            MappedFile& column = entry.columns[i];
+            if (!column.open((entry.dir / column_name(i)).string()) || column.size() < header.count * sizeof(double)) {
+                log_warn() << "Candle archive column is missing or truncated: " << (entry.dir / column_name(i)).string();
+                for (auto& mapped : entry.columns) mapped.close();
+                return;
+            }
+        }
+        entry.header = header;
+    }
+
+    static bool covers(const Entry& entry, long long start, long long end) {
+        return entry.header.count != 0 && entry.header.covered_start <= start && end <= entry.header.covered_end;
+    }
+
+    template <typename T>
+    static Span<const T> column(const Entry& entry, size_t index) {
+        return { reinterpret_cast<const T*>(entry.columns[index].data()), static_cast<size_t>(entry.header.count) };
+    }
+
+    // Свечи архива с временем открытия в [start, end] секунд
+    static void read(const Entry& entry, long long start, long long end, CandleSeries& out) {
+        if (entry.header.count == 0) return;
+        Span<const int64_t> timestamps = column<int64_t>(entry, 0);
+        size_t first = std::lower_bound(timestamps.begin(), timestamps.end(), start * 1000) - timestamps.begin();
+        size_t last = std::lower_bound(timestamps.begin(), timestamps.end(), (end + 1) * 1000) - timestamps.begin();
+        if (first >= last) return;
+        size_t count = last - first;
+        out.reserve(out.size() + count);
+        out.append(timestamps.subspan(first, count),
+            column<double>(entry, 1).subspan(first, count),
+            column<double>(entry, 2).subspan(first, count),
+            column<double>(entry, 3).subspan(first, count),
+            column<double>(entry, 4).subspan(first, count),
+            column<double>(entry, 5).subspan(first, count),
+            column<double>(entry, 6).subspan(first, count));
+    }
+
+    // Ошибка информера не роняет запрос: отдаём то, что есть в архиве; failed отличает её от пустого ответа
+    CandleSeries fetch(Informer& informer, const std::string& symbol, long long start, long long end,
+        const std::string& interval, bool* failed = nullptr) {
+        try {
+            std::vector<CandleData> response;
+            {
+                ScopedTimer timer(Metrics::informer_latency(typeid(informer), "get_symbol_historical"));
+                response = informer.get_symbol_historical(symbol, std::to_string(start), std::to_string(end), interval);
+            }
+            CandleSeries candles = CandleSeries::from_candles(response);
+            fetched_candles_.fetch_add(candles.size(), std::memory_order_relaxed);
+            return candles;
+        }
+        catch (const std::exception& e) {
+            log_error().symbol(symbol) << "Error fetching candles for archive (" << symbol << ", " << interval << "): "
+                << e.what();
+            if (failed != nullptr) *failed = true;
+            return CandleSeries();
+        }
+    }
+
+    // Свечи информера с временем открытия в [start, end]
+    CandleSeries fetch_range(Informer& informer, const std::string& symbol, long long start, long long end,
+        const std::string& interval, bool* failed = nullptr) {
+        CandleSeries fetched = fetch(informer, symbol, start, end, interval, failed);
+        CandleSeries candles;
+        candles.append(fetched, fetched.lower_bound(start * 1000), fetched.lower_bound((end + 1) * 1000));
+        return candles;
+    }
+
+    // Загружает участок [start, end], примыкающий к покрытию, и дописывает его в архив.
+    // Ответ информера может быть урезан лимитом свечей на запрос, поэтому края, до которых он не дошёл,
+    // запрашиваются снова, пока информер не ответит пустым списком. Если догрузить край не удалось,
+    // покрытие ограничивается полученными свечами. Вызывается под исключительной блокировкой ряда
+    size_t load(Entry& entry, Informer& informer, const std::string& symbol, const std::string& interval,
+        long long start, long long end) {
+        long long step = TimeUtils::interval_seconds(interval);
+        CandleSeries candles = fetch_range(informer, symbol, start, end, interval);
+        // Пустой ответ может означать ошибку сети, такой участок покрытым не считаем
+        if (candles.empty()) return 0;
+
+        long long covered_start = start;
+        long long covered_end = end;
+        for (;;) {
+            long long from = candles.timestamp(candles.size() - 1) / 1000 + step;
+            if (from > end) break;
+            bool failed = false;
+            CandleSeries more = fetch_range(informer, symbol, from, end, interval, &failed);
+            if (failed) {
+                covered_end = from - 1;
+                break;
+            }
+            if (more.empty()) break; // свечей после последней полученной у информера нет
+            candles.append(more);
+        }
+        for (;;) {
+            long long first = TimeUtils::align_down(candles.timestamp(0) / 1000, step);
+            if (first - step < start) break;
+            bool failed = false;
+            CandleSeries more = fetch_range(informer, symbol, start, first - 1, interval, &failed);
+            if (failed) {
+                covered_start = first;
+                break;
+            }
+            if (more.empty()) break;
+            more.append(candles);
+            candles = std::move(more);
+        }
+
+        size_t added = candles.size();
+        Header header = entry.header;
+        try {
+            if (header.count == 0) {
+                header.covered_start = covered_start;
+                header.covered_end = covered_end;
+                rewrite(entry, candles, header);
+            }
+            else if (start == header.covered_end + 1) {
+                // Покрытие остаётся непрерывным: участок без подтверждённого начала не дописывается
+                if (covered_start != start) return 0;
+                header.covered_end = covered_end;
+                append(entry, candles, header);
+            }
+            else if (end == header.covered_start - 1) {
+                // Участок перед началом архива: файлы переписываются целиком
+                if (covered_end != end) return 0;
+                read(entry, header.covered_start, header.covered_end, candles);
+                header.covered_start = covered_start;
+                rewrite(entry, candles, header);
+            }
+            else {
+                return 0;
+            }
+        }
+        catch (const std::exception& e) {
+            log_error() << "Error writing candle archive " << entry.dir.string() << ": " << e.what();
+            open_entry(entry);
+            return 0;
+        }
+        archived_candles_.fetch_add(added, std::memory_order_relaxed);
+        return added;
+    }
+
+    template <typename T>
+    static void write_column(const std::filesystem::path& path, Span<const T> values, std::ios::openmode mode) {
+        std::ofstream file(path, std::ios::binary | mode);
+        file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+        file.close();
+        if (!file) throw std::runtime_error("cannot write " + path.string());
+    }
+
+    static void write_columns(const Entry& entry, const CandleSeries& candles, const std::string& suffix,
+        std::ios::openmode mode) {
+        write_column(entry.dir / (std::string(column_name(0)) + suffix), candles.timestamps(), mode);
+        write_column(entry.dir / (std::string(column_name(1)) + suffix), candles.open(), mode);
+        write_column(entry.dir / (std::string(column_name(2)) + suffix), candles.high(), mode);
+        write_column(entry.dir / (std::string(column_name(3)) + suffix), candles.low(), mode);
+        write_column(entry.dir / (std::string(column_name(4)) + suffix), candles.close(), mode);
+        write_column(entry.dir / (std::string(column_name(5)) + suffix), candles.volume(), mode);
+        write_column(entry.dir / (std::string(column_name(6)) + suffix), candles.turnover(), mode);
+    }
+
+    // Заголовок заменяется атомарно через временный файл
+    static void write_header(const Entry& entry, Header header) {
+        std::memcpy(header.magic, "TSCA", 4);
+        header.version = format_version;
+        std::filesystem::path temp = entry.dir / "header.bin.tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.close();
+            if (!file) throw std::runtime_error("cannot write " + temp.string());
+        }
+        std::filesystem::rename(temp, entry.dir / "header.bin");
+    }
+
+    // Дописывает свечи в конец столбцов; хвост от прерванной записи сначала отрезается.
+    // Новые свечи становятся видны только после замены заголовка
+    static void append(Entry& entry, const CandleSeries& candles, Header header) {
+        for (auto& column : entry.columns) column.close();
+        std::uintmax_t valid_size = entry.header.count * sizeof(double);
+        for (size_t i = 0; i < column_count; ++i) {
+            std::filesystem::path path = entry.dir / column_name(i);
+            if (std::filesystem::file_size(path) != valid_size) {
+                std::filesystem::resize_file(path, valid_size);
+            }
+        }
+        write_columns(entry, candles, "", std::ios::app);
+        header.count = entry.header.count + candles.size();
+        write_header(entry, header);
+        open_entry(entry);
+    }
+
+    // Полная перезапись ряда: столбцы пишутся во временные файлы, на время замены ряд помечается пустым
+    static void rewrite(Entry& entry, const CandleSeries& candles, Header header) {
+        for (auto& column : entry.columns) column.close();
+        std::filesystem::create_directories(entry.dir);
+        write_columns(entry, candles, ".tmp", std::ios::trunc);
+        write_header(entry, Header{});
+        for (size_t i = 0; i < column_count; ++i) {
+            std::filesystem::rename(entry.dir / (std::string(column_name(i)) + ".tmp"), entry.dir / column_name(i));
+        }
+        header.count = candles.size();
+        write_header(entry, header);
+        open_entry(entry);
+    }
+};
+
+#endif // CANDLE_ARCHIVE_HPP
@@ -0,0 +1,167 @@
+#ifndef CANDLE_BACKFILL_HPP
+#define CANDLE_BACKFILL_HPP
+
+#include "./CandleArchive.hpp"
+#include "../Informers/Informer.hpp"
+#include "../Utils/TimeUtils.hpp"
+#include "../Utils/Logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Счётчики фоновой догрузки архива
+struct CandleBackfillStats {
+    size_t queued;
+    bool running;
+    uint64_t completed;  // заданий, после которых период покрыт целиком
+    uint64_t incomplete; // информер перестал отдавать свечи раньше
+    uint64_t candles;    // свечей дописано в архив
+};
+
+// Фоновая догрузка периода в архив свечей: задания выполняются по одному, участками по chunk_candles свечей
+// с паузой между запросами, чтобы не упираться в ограничения API бирж
+class CandleBackfill {
+public:
+    static CandleBackfill& getInstance() {
+        static CandleBackfill instance;
+        return instance;
+    }
+
+    ~CandleBackfill() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (worker_.joinable()) worker_.join();
+    }
+
+    // Период [start, end] в секундах от эпохи; возвращает число заданий в очереди
+    size_t enqueue(std::shared_ptr<Informer> informer, const std::string& symbol, const std::string& interval,
+        long long start, long long end) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.push_back({ std::move(informer), symbol, interval, start, end });
+        if (!worker_.joinable()) {
+            worker_ = std::thread([this]() { run(); });
+        }
+        wake_.notify_all();
+        return jobs_.size();
+    }
+
+    CandleBackfillStats get_stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {
+            jobs_.size(),
+            running_,
+            completed_.load(std::memory_order_relaxed),
+            incomplete_.load(std::memory_order_relaxed),
+            candles_.load(std::memory_order_relaxed)
+        };
+    }
+
+private:
+    struct Job {
+        std::shared_ptr<Informer> informer;
+        std::string symbol;
+        std::string interval;
+        long long start;
+        long long end;
+    };
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Job> jobs_;
+    bool stopping_ = false;
+    bool running_ = false;
+    std::thread worker_;
+    size_t chunk_candles_ = 1000;
+    std::chrono::milliseconds pause_{ 250 };
+
+    std::atomic<uint64_t> completed_{ 0 };
+    std::atomic<uint64_t> incomplete_{ 0 };
+    std::atomic<uint64_t> candles_{ 0 };
+
+    CandleBackfill() {
+        // Архив должен пережить поток догрузки
+        CandleArchive::getInstance();
+
+        const char* value = std::getenv("TRADESNAKE_BACKFILL_CHUNK");
+        if (value != nullptr) {
+            try {
+                chunk_candles_ = std::max<size_t>(1, std::stoull(value));
+            }
+            catch (const std::exception&) {
+                log_warn() << "Invalid value of TRADESNAKE_BACKFILL_CHUNK: " << value;
+            }
+        }
+        value = std::getenv("TRADESNAKE_BACKFILL_PAUSE_MS");
+        if (value != nullptr) {
+            try {
+                pause_ = std::chrono::milliseconds(std::max(0L, std::stol(value)));
+            }
+            catch (const std::exception&) {
+                log_warn() << "Invalid value of TRADESNAKE_BACKFILL_PAUSE_MS: " << value;
+            }
+        }
+    }
+
+    CandleBackfill(const CandleBackfill&) = delete;
+    CandleBackfill& operator=(const CandleBackfill&) = delete;
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            wake_.wait(lock, [this]() { return stopping_ || !jobs_.empty(); });
+            if (stopping_) break;
+            Job job = std::move(jobs_.front());
+            jobs_.pop_front();
+            running_ = true;
+            lock.unlock();
+            process(job);
+            lock.lock();
+            running_ = false;
+        }
+    }
+
+    void process(const Job& job) {
+        CandleArchive& archive = CandleArchive::getInstance();
+        try {
+            while (true) {
+                size_t added = archive.extend(job.informer, job.symbol, job.interval, job.start, job.end, chunk_candles_);
+                if (added == 0) break;
+                candles_.fetch_add(added, std::memory_order_relaxed);
+
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (wake_.wait_for(lock, pause_, [this]() { return stopping_; })) return;
+            }
+        }
+        catch (const std::exception& e) {
+            log_error() << "Error in candle backfill for " << job.symbol << ": " << e.what();
+        }
+
+        long long step = TimeUtils::interval_seconds(job.interval);
+        long long closed_end = std::min(job.end, TimeUtils::align_down(TimeUtils::now_seconds(), step) - 1);
+        long long covered_start = 0;
+        long long covered_end = 0;
+        if (archive.coverage(*job.informer, job.symbol, job.interval, covered_start, covered_end) &&
+            covered_start <= TimeUtils::align_down(job.start, step) && closed_end <= covered_end) {
+            completed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        else {
+            incomplete_.fetch_add(1, std::memory_order_relaxed);
+            log_warn().symbol(job.symbol) << "Candle backfill for " << job.symbol << " (" << job.interval
+                << ") stopped before covering the requested period";
+        }
+    }
+};
+
+#endif // CANDLE_BACKFILL_HPP
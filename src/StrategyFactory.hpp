@@ -7,29 +7,43 @@
 #include <stdexcept>
 #include <string>
 #include <map>
+#include "./StrategyParams.hpp"
 
-//   
+// Предварительные объявления классов
 class TradeBot;
 class Informer;
 
-//     
-using BotFactory = std::function<std::unique_ptr<TradeBot>( int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>&)>;
+// Псевдоним типа для фабричной функции; параметры уже проверены по схеме стратегии
+using BotFactory = std::function<std::unique_ptr<TradeBot>( int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams&)>;
 
-//  
+// Фабрика стратегий
 class StrategyFactory {
 public:
-    //   
+    // Получение экземпляра синглтона
     static StrategyFactory& getInstance() {
         static StrategyFactory instance;
         return instance;
     }
 
-    //  
-    void registerStrategy(int strategy_id, BotFactory factory) {
-        strategies_[strategy_id] = std::move(factory);
+    // Регистрация стратегии вместе со схемой её параметров
+    void registerStrategy(int strategy_id, BotFactory factory, StrategySpec spec = StrategySpec()) {
+        strategies_[strategy_id] = { std::move(factory), std::move(spec) };
     }
 
-    //  
+    // Портфельный бот: стратегия strategy_id на списке символов из параметра symbols (PortfolioBot)
+    void registerPortfolio(BotFactory factory) {
+        portfolio_ = std::move(factory);
+    }
+
+    // Проверка параметров без создания бота: неверный ввод отклоняется до запуска.
+    // Бросает InvalidParams или std::runtime_error для неизвестной стратегии
+    StrategyParams validate(int strategy_id, const std::map<std::string, std::string>& params) const {
+        const Registration& registration = find(strategy_id);
+        if (PortfolioParams::requested(params)) return validate_portfolio(registration.spec, params);
+        return registration.spec.validate(params);
+    }
+
+    // Создание стратегии
     std::unique_ptr<TradeBot> createStrategy(
         int strategy_id,
         int user_id,
@@ -37,23 +51,49 @@ public:
         int broker_id,
         const std::map<std::string, std::string>& params
     ) const {
-        auto it = strategies_.find(strategy_id);
-        if (it != strategies_.end()) {
-            return it->second(user_id, bot_id, strategy_id, broker_id, params);
+        const Registration& registration = find(strategy_id);
+        return registration.factory(user_id, bot_id, strategy_id, broker_id, registration.spec.validate(params));
+    }
+
+    // Бот для торговли: с параметром symbols - портфель из ботов стратегии по каждому символу
+    std::unique_ptr<TradeBot> createBot(
+        int strategy_id,
+        int user_id,
+        int bot_id,
+        int broker_id,
+        const std::map<std::string, std::string>& params
+    ) const {
+        if (!PortfolioParams::requested(params)) return createStrategy(strategy_id, user_id, bot_id, broker_id, params);
+        if (!portfolio_) {
+            throw std::runtime_error("Portfolio bots are not registered");
         }
-        throw std::runtime_error("Unknown strategy ID");
+        return portfolio_(user_id, bot_id, strategy_id, broker_id, validate(strategy_id, params));
     }
 
 private:
-    //    
+    // Приватный конструктор для синглтона
     StrategyFactory() = default;
 
-    //      
+    // Удаление конструктора копирования и оператора присваивания
     StrategyFactory(const StrategyFactory&) = delete;
     StrategyFactory& operator=(const StrategyFactory&) = delete;
 
-    //   
-    std::unordered_map<int, BotFactory> strategies_;
+    struct Registration {
+        BotFactory factory;
+        StrategySpec spec;
+    };
+
+    // Хранилище зарегистрированных стратегий
+    std::unordered_map<int, Registration> strategies_;
+    BotFactory portfolio_;
+
+    const Registration& find(int strategy_id) const {
+        auto it = strategies_.find(strategy_id);
+        if (it == strategies_.end()) {
+            throw std::runtime_error("Unknown strategy ID");
+        }
+        return it->second;
+    }
 };
 
 #endif // STRATEGY_FACTORY_HPP
\ No newline at end of file
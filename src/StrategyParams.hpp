@@ -0,0 +1,355 @@
+#ifndef STRATEGY_PARAMS_HPP
+#define STRATEGY_PARAMS_HPP
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using ParamMap = std::map<std::string, std::string>;
+
+// Неверные параметры стратегии; сообщение перечисляет все неверные поля
+class InvalidParams : public std::invalid_argument {
+public:
+    using std::invalid_argument::invalid_argument;
+
+    static InvalidParams listing(const std::vector<std::string>& errors) {
+        std::string message = "Invalid strategy parameters: ";
+        for (size_t i = 0; i < errors.size(); ++i) {
+            if (i != 0) message += "; ";
+            message += errors[i];
+        }
+        return InvalidParams(message);
+    }
+};
+
+// Описание параметров блока Block: ключ, поле структуры, значение по умолчанию (nullopt - ключ обязателен)
+// и допустимый диапазон. parse переводит строки в типы один раз, при создании бота.
+// Ключи, которых нет в схеме, не проверяются и остаются в исходном словаре.
+template <typename Block>
+class ParamSchema {
+public:
+    ParamSchema& integer(const std::string& name, int Block::* field, std::optional<int> fallback,
+        int min = INT_MIN, int max = INT_MAX) {
+        fields_.push_back([=](Block& block, const ParamMap& params, std::vector<std::string>& errors) {
+            const std::string* text = find(params, name, fallback.has_value(), errors);
+            if (text == nullptr) {
+                if (fallback) block.*field = *fallback;
+                return;
+            }
+            double value;
+            if (!to_number(*text, value) || value != std::floor(value)) {
+                errors.push_back(name + ": expected an integer, got '" + *text + "'");
+            }
+            else if (value < min || value > max) {
+                errors.push_back(name + ": must be in [" + std::to_string(min) + ", " + std::to_string(max) + "]");
+            }
+            else {
+                block.*field = static_cast<int>(value);
+            }
+            });
+        return *this;
+    }
+
+    ParamSchema& number(const std::string& name, double Block::* field, std::optional<double> fallback,
+        double min = -std::numeric_limits<double>::infinity(), double max = std::numeric_limits<double>::infinity()) {
+        fields_.push_back([=](Block& block, const ParamMap& params, std::vector<std::string>& errors) {
+            const std::string* text = find(params, name, fallback.has_value(), errors);
+            if (text == nullptr) {
+                if (fallback) block.*field = *fallback;
+                return;
+            }
+            double value;
+            if (!to_number(*text, value)) {
+                errors.push_back(name + ": expected a number, got '" + *text + "'");
+            }
+            else if (value < min || value > max) {
+                errors.push_back(name + ": must be in [" + format(min) + ", " + format(max) + "]");
+            }
+            else {
+                block.*field = value;
+            }
+            });
+        return *this;
+    }
+
+    ParamSchema& text(const std::string& name, std::string Block::* field, std::optional<std::string> fallback) {
+        fields_.push_back([=](Block& block, const ParamMap& params, std::vector<std::string>& errors) {
+            const std::string* text = find(params, name, fallback.has_value(), errors);
+            if (text == nullptr) {
+                if (fallback) block.*field = *fallback;
+                return;
+            }
+            if (text->empty()) {
+                errors.push_back(name + ": must not be empty");
+                return;
+            }
+            block.*field = *text;
+            });
+        return *this;
+    }
+
+    // Ошибки дописываются в errors, чтобы ответ перечислил все неверные поля сразу
+    Block parse(const ParamMap& params, std::vector<std::string>& errors) const {
+        Block block{};
+        for (const auto& field : fields_) field(block, params, errors);
+        return block;
+    }
+
+private:
+    std::vector<std::function<void(Block&, const ParamMap&, std::vector<std::string>&)>> fields_;
+
+    static const std::string* find(const ParamMap& params, const std::string& name, bool optional,
+        std::vector<std::string>& errors) {
+        auto it = params.find(name);
+        if (it != params.end()) return &it->second;
+        if (!optional) errors.push_back(name + ": required");
+        return nullptr;
+    }
+
+    // Число целиком, без хвоста; значения JSON приходят текстом json::dump, значения из БД - std::to_string
+    static bool to_number(const std::string& text, double& value) {
+        if (text.empty()) return false;
+        char* end = nullptr;
+        value = std::strtod(text.c_str(), &end);
+        return end == text.c_str() + text.size() && std::isfinite(value);
+    }
+
+    static std::string format(double value) {
+        if (std::isinf(value)) return value < 0 ? "-inf" : "inf";
+        std::string text = std::to_string(value);
+        text.erase(text.find_last_not_of('0') + 1);
+        if (!text.empty() && text.back() == '.') text.pop_back();
+        return text;
+    }
+};
+
+// Общие параметры, которые читает сам TradeBot
+struct BotParams {
+    std::string symbol;
+    std::string interval;
+    double money;
+    double symbol_count;
+    std::string start_date; // период бэктеста, секунды от эпохи
+    std::string end_date;
+
+    static const ParamSchema<BotParams>& schema() {
+        static const ParamSchema<BotParams> instance = ParamSchema<BotParams>()
+            .text("symbol", &BotParams::symbol, std::nullopt)
+            .text("interval", &BotParams::interval, std::string("d"))
+            .number("money", &BotParams::money, 0.0, 0.0, INT_MAX) // TradeBot хранит деньги в int
+            .number("symbol_count", &BotParams::symbol_count, 0.0, 0.0)
+            .text("start_date", &BotParams::start_date, std::string("0"))
+            .text("end_date", &BotParams::end_date, std::string("0"));
+        return instance;
+    }
+};
+
+// Собственный блок параметров стратегии без указания типа; тип проверяется при чтении
+class ParamBlock {
+public:
+    ParamBlock() = default;
+    ParamBlock(std::shared_ptr<const void> value, const std::type_info& type) : value_(std::move(value)), type_(&type) {}
+
+    template <typename Block>
+    const Block& get() const {
+        if (!value_ || *type_ != typeid(Block)) {
+            throw std::logic_error(std::string("Strategy parameters are not registered as ") + typeid(Block).name());
+        }
+        return *static_cast<const Block*>(value_.get());
+    }
+
+private:
+    std::shared_ptr<const void> value_;
+    const std::type_info* type_ = nullptr;
+};
+
+// Проверенные параметры бота: исходный словарь, общий блок и блок стратегии.
+// Приводится к словарю, поэтому подходит и конструкторам стратегий, которые принимают std::map
+class StrategyParams {
+public:
+    StrategyParams(ParamMap raw, BotParams bot, ParamBlock block)
+        : raw_(std::move(raw)), bot_(std::move(bot)), block_(std::move(block)) {
+    }
+
+    const ParamMap& raw() const { return raw_; }
+    const BotParams& bot() const { return bot_; }
+    const ParamBlock& block() const { return block_; }
+
+    operator const ParamMap&() const { return raw_; }
+
+private:
+    ParamMap raw_;
+    BotParams bot_;
+    ParamBlock block_;
+};
+
+// Схема стратегии для регистрации в StrategyFactory: общий блок BotParams и, если задан, собственный блок.
+// Пример в strategy_registrations.hpp:
+//   struct MAParams { int ma_length; };
+//   StrategySpec(ParamSchema<MAParams>().integer("ma_length", &MAParams::ma_length, 20, 1, 1000))
+// после чего стратегия читает поля через strategy_params<MAParams>() в конструкторе
+class StrategySpec {
+public:
+    StrategySpec() = default;
+
+    template <typename Block>
+    explicit StrategySpec(ParamSchema<Block> schema)
+        : parse_block_([schema = std::move(schema)](const ParamMap& params, std::vector<std::string>& errors) {
+        return ParamBlock(std::make_shared<const Block>(schema.parse(params, errors)), typeid(Block));
+            }) {
+    }
+
+    // Бросает InvalidParams со списком всех ошибок
+    StrategyParams validate(const ParamMap& params) const {
+        std::vector<std::string> errors;
+        BotParams bot = BotParams::schema().parse(params, errors);
+        ParamBlock block = parse_block_ ? parse_block_(params, errors) : ParamBlock();
+        if (!errors.empty()) throw InvalidParams::listing(errors);
+        return StrategyParams(params, std::move(bot), std::move(block));
+    }
+
+private:
+    std::function<ParamBlock(const ParamMap&, std::vector<std::string>&)> parse_block_;
+};
+
+// Позиция одного символа портфеля
+struct PortfolioPosition {
+    double money = 0;
+    double symbol_count = 0;
+};
+
+// Параметры портфельного бота (PortfolioBot): одна стратегия на списке символов.
+// symbols - JSON-массив или строка через запятую. positions - позиции по символам, которые портфель
+// сохраняет в strategy_parameters вместе со сделками; символ без сохранённой позиции получает
+// равную долю свободных денег (money за вычетом денег сохранённых позиций) и начинает без актива
+struct PortfolioParams {
+    std::vector<std::string> symbols;
+    std::map<std::string, PortfolioPosition> positions; // по каждому символу из symbols
+
+    static bool requested(const ParamMap& params) { return params.count("symbols") != 0; }
+
+    // Символы через запятую: так портфель выглядит в журнале и в ключе группы планировщика
+    std::string joined_symbols() const {
+        std::string joined;
+        for (const auto& symbol : symbols) {
+            if (!joined.empty()) joined += ",";
+            joined += symbol;
+        }
+        return joined;
+    }
+
+    // Параметры бота одного символа: те же параметры стратегии, свой символ и своя позиция
+    ParamMap member_params(const ParamMap& params, const std::string& symbol) const {
+        ParamMap member = params;
+        member.erase("symbols");
+        member.erase("positions");
+        member["symbol"] = symbol;
+        auto position = positions.find(symbol);
+        if (position != positions.end()) {
+            member["money"] = std::to_string(position->second.money);
+            member["symbol_count"] = std::to_string(position->second.symbol_count);
+        }
+        return member;
+    }
+
+    static std::vector<std::string> parse_symbols(const std::string& text, std::vector<std::string>& errors) {
+        std::vector<std::string> listed;
+        if (!text.empty() && text.front() == '[') {
+            nlohmann::json value = nlohmann::json::parse(text, nullptr, false);
+            if (!value.is_array()) {
+                errors.push_back("symbols: expected a JSON array or a comma-separated list");
+                return {};
+            }
+            for (const auto& item : value) {
+                if (!item.is_string()) {
+                    errors.push_back("symbols: expected strings, got " + item.dump());
+                    return {};
+                }
+                listed.push_back(item.get<std::string>());
+            }
+        }
+        else {
+            size_t begin = 0;
+            while (begin <= text.size()) {
+                size_t end = text.find(',', begin);
+                if (end == std::string::npos) end = text.size();
+                listed.push_back(text.substr(begin, end - begin));
+                begin = end + 1;
+            }
+        }
+
+        std::vector<std::string> symbols;
+        for (auto& symbol : listed) {
+            size_t first = symbol.find_first_not_of(" \t");
+            if (first == std::string::npos) continue;
+            symbol = symbol.substr(first, symbol.find_last_not_of(" \t") - first + 1);
+            if (std::find(symbols.begin(), symbols.end(), symbol) == symbols.end()) symbols.push_back(symbol);
+        }
+        if (symbols.empty()) errors.push_back("symbols: must list at least one symbol");
+        return symbols;
+    }
+
+    // Позиции всех символов: сохранённые из positions, остальным - доли свободных денег
+    void assign_positions(const ParamMap& params, double money, std::vector<std::string>& errors) {
+        auto saved = params.find("positions");
+        if (saved != params.end() && !saved->second.empty()) {
+            nlohmann::json value = nlohmann::json::parse(saved->second, nullptr, false);
+            if (!value.is_object()) {
+                errors.push_back("positions: expected a JSON object");
+                return;
+            }
+            for (const auto& symbol : symbols) {
+                auto item = value.find(symbol);
+                if (item == value.end()) continue;
+                const nlohmann::json& position = *item;
+                if (!position.is_object() || !position.value("money", nlohmann::json()).is_number() ||
+                    !position.value("symbol_count", nlohmann::json()).is_number()) {
+                    errors.push_back("positions: " + symbol + " must have numeric money and symbol_count");
+                    continue;
+                }
+                positions[symbol] = { position["money"].get<double>(), position["symbol_count"].get<double>() };
+            }
+        }
+
+        double free_money = money;
+        for (const auto& position : positions) free_money -= position.second.money;
+        size_t unassigned = symbols.size() - positions.size();
+        for (const auto& symbol : symbols) {
+            if (positions.count(symbol)) continue;
+            positions[symbol] = { std::max(0.0, free_money) / unassigned, 0.0 };
+        }
+    }
+};
+
+// Проверка параметров портфеля: общий блок с символом-списком, разбор symbols и positions
+// и проверка параметров каждого символа по схеме стратегии member_spec
+inline StrategyParams validate_portfolio(const StrategySpec& member_spec, const ParamMap& params) {
+    std::vector<std::string> errors;
+    auto portfolio = std::make_shared<PortfolioParams>();
+    portfolio->symbols = PortfolioParams::parse_symbols(params.at("symbols"), errors);
+
+    ParamMap own = params;
+    own["symbol"] = portfolio->symbols.empty() ? "symbols" : portfolio->joined_symbols();
+    BotParams bot = BotParams::schema().parse(own, errors);
+    if (errors.empty()) portfolio->assign_positions(params, bot.money, errors);
+    if (!errors.empty()) throw InvalidParams::listing(errors);
+
+    for (const auto& symbol : portfolio->symbols) {
+        member_spec.validate(portfolio->member_params(params, symbol));
+    }
+    return StrategyParams(std::move(own), std::move(bot), ParamBlock(std::move(portfolio), typeid(PortfolioParams)));
+}
+
+#endif // STRATEGY_PARAMS_HPP
@@ -7,10 +7,14 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <algorithm>
+#include <cstdlib>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
 #include <boost/asio/io_context.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/signal_set.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/beast/version.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
@@ -25,6 +29,15 @@
 #include "./const.hpp"
 #include "./struct.hpp"
 #include "./Analyzers/MarketAnalyzer.hpp"
+#include "./Server/HttpServer.hpp"
+#include "./Server/ColumnarWriter.hpp"
+#include "./Server/RequestJson.hpp"
+#include "./Cache/CandleCache.hpp"
+#include "./Cache/BrokerMetadataCache.hpp"
+#include "./Storage/CandleBackfill.hpp"
+#include "./Database/ConnectionPool.hpp"
+#include "./Utils/Metrics.hpp"
+#include "./Utils/Logger.hpp"
 
 
 using json = nlohmann::json; // Используем nlohmann::json
@@ -34,41 +47,33 @@ namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
 using json = nlohmann::json; // Используем nlohmann::json
 
-// Функция для парсинга JSON из тела запроса
-std::map<std::string, std::string> parse_json_body(const std::string& body) {
-    std::map<std::string, std::string> result;
-    try {
-        auto json_value = json::parse(body); // Парсим JSON
-        if (json_value.is_object()) {
-            for (auto it = json_value.begin(); it != json_value.end(); ++it) {
-                const std::string& key = it.key();
-                const auto& value = it.value();
-
-                if (value.is_string()) {
-                    result[key] = value.get<std::string>();
-                }
-                else {
-                    result[key] = value.dump(); // Преобразуем в строку, если это не строква
-                }
-            }
-        }
-    }
-    catch (const std::exception& e) {
-        std::cerr << "JSON parsing error: " << e.what() << std::endl;
-    }
-    return result;
-}
 
 bool is_allowed_ip(const boost::asio::ip::tcp::endpoint& endpoint) {
     std::string client_ip = endpoint.address().to_string();
     return Constants::allowed_ips.find(client_ip) != Constants::allowed_ips.end();
 }
-void handle_execute_historical(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
-    auto params = parse_json_body(req.body());
+// Клиент просит двоичный столбцовый формат (Accept: application/vnd.tradesnake.columnar) вместо JSON
+bool wants_columnar(const http::request<http::string_body>& req) {
+    return std::string(req[http::field::accept]).find(ColumnarWriter::content_type) != std::string::npos;
+}
+
+// Элемент потокового JSON-массива; если клиент отключился, расчёт прерывается
+void write_array_item(ChunkedWriter& out, bool& first, const json& item) {
+    if (!first && !out.write(",", 1)) {
+        throw std::runtime_error("client disconnected");
+    }
+    first = false;
+    if (!out.write(item.dump())) {
+        throw std::runtime_error("client disconnected");
+    }
+}
+
+void handle_execute_historical(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler, ResponseStream& stream) {
+    RequestParams params(req.body());
 
-    if (params.find("user_id") == params.end() ||
-        params.find("strategy_id") == params.end() || params.find("broker_id") == params.end() ||
-        params.find("strategy_parameters") == params.end()) {
+    if (!params.contains("user_id") ||
+        !params.contains("strategy_id") || !params.contains("broker_id") ||
+        !params.contains("strategy_parameters")) {
 
         res.result(http::status::bad_request);
         res.set(http::field::content_type, "text/plain");
@@ -77,41 +82,251 @@ void handle_execute_historical(http::request<http::string_body>& req, http::resp
     }
 
     // Извлекаем параметры из JSON
-    int user_id = std::stoi(params["user_id"]);
+    int user_id = params.get_int("user_id");
     int bot_id = -1;   
-    int strategy_id = std::stoi(params["strategy_id"]);
-    int broker_id = std::stoi(params["broker_id"]);
+    int strategy_id = params.get_int("strategy_id");
+    int broker_id = params.get_int("broker_id");
 
     // Параметры стратегии
     std::map<std::string, std::string> strategy_params;
-    if (params.find("strategy_parameters") != params.end()) {
-        auto strategy_params_json = json::parse(params["strategy_parameters"]);
-        for (auto it = strategy_params_json.begin(); it != strategy_params_json.end(); ++it) {
-            const std::string& key = it.key();
-            const auto& value = it.value();
-            strategy_params[key] = value.is_string() ? value.get<std::string>() : value.dump();
-        }
+    try {
+        strategy_params = params.strategy_params();
+        StrategyFactory::getInstance().validate(strategy_id, strategy_params);
+    }
+    catch (const std::exception& e) {
+        res.result(http::status::bad_request);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Invalid parameter format: " + std::string(e.what());
+        return;
     }
 
-    // Запускаем бэктестинг и получаем результаты
-    std::vector<HistoricalResult> results = bot_handler.start_execute_historical(
+    // Бот и свечи готовим до отправки заголовков, чтобы ошибки ещё можно было вернуть статусом
+    std::shared_ptr<TradeBot> bot = bot_handler.create_backtest_bot(
         user_id, bot_id, strategy_id, broker_id, strategy_params);
+    auto candles = std::make_shared<CandleSeries>(bot->load_historical_candles());
+
+    const bool columnar = wants_columnar(req);
+    res.result(http::status::ok);
+    res.set(http::field::content_type, columnar ? ColumnarWriter::content_type : "application/json");
+
+    // Результат по каждой свече сериализуется сразу в ответ, пока идёт бэктест
+    stream.start([bot, candles, columnar](ChunkedWriter& out) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        if (columnar) {
+            ColumnarWriter writer(out, ColumnarWriter::Kind::Backtest);
+            bot->execute_historical(*candles, [&writer, &candles](size_t i, const TradeEvent* trade) {
+                writer.add_row(candles->timestamp(i), candles->open()[i], candles->high()[i], candles->low()[i],
+                    candles->close()[i], candles->volume()[i], candles->turnover()[i]);
+                if (trade) {
+                    writer.add_event(trade->side == 1 ? ColumnarWriter::Side::Buy : ColumnarWriter::Side::Sell,
+                        trade->price, trade->broker_price, trade->quantity);
+                }
+                });
+            writer.finish();
+            return;
+        }
+        bool first = true;
+        out.write("[", 1);
+        bot->execute_historical(*candles, [&out, &first, &candles](size_t i, const TradeEvent* trade) {
+            write_array_item(out, first, historical_candle_json(*candles, i, trade));
+            });
+        out.write("]", 1);
+
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::high_resolution_clock::now() - start_time).count();
+        log_info() << "Execution time of execute_historical: " << duration << " milliseconds";
+        });
+}
+
+// Перебор параметров стратегии на исторических данных
+void handle_optimize(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    RequestParams params(req.body());
+
+    if (!params.contains("user_id") ||
+        !params.contains("strategy_id") || !params.contains("broker_id") ||
+        !params.contains("strategy_parameters") || !params.contains("parameter_grid")) {
+
+        res.result(http::status::bad_request);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Missing required parameters: user_id, strategy_id, broker_id, strategy_parameters or parameter_grid.";
+        return;
+    }
+
+    int user_id;
+    int strategy_id;
+    int broker_id;
+    std::map<std::string, std::string> strategy_params;
+    ParameterGrid grid;
+    std::string sort_by = params.contains("sort_by") ? std::string(params["sort_by"]) : "pnl";
+    size_t top = 50;
+    try {
+        user_id = params.get_int("user_id");
+        strategy_id = params.get_int("strategy_id");
+        broker_id = params.get_int("broker_id");
+        if (params.contains("top")) {
+            top = static_cast<size_t>(std::stoul(std::string(params["top"])));
+        }
+
+        strategy_params = params.strategy_params();
+        const json* grid_json = params.json_value("parameter_grid");
+        grid = ParameterGrid::from_json(grid_json->is_string() ? json::parse(grid_json->get_ref<const std::string&>()) : *grid_json);
+        // Общие параметры проверяем вместе с первой комбинацией: часть ключей может задавать только сетка
+        StrategyFactory::getInstance().validate(strategy_id, grid.size() > 0 ? grid.combination(0, strategy_params) : strategy_params);
+    }
+    catch (const std::exception& e) {
+        res.result(http::status::bad_request);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Invalid parameter format: " + std::string(e.what());
+        return;
+    }
+
+    std::vector<SweepResult> results = bot_handler.start_optimize(
+        user_id, strategy_id, broker_id, strategy_params, grid, sort_by, top);
 
-    json response_json = json::array();
+    json results_json = json::array();
     for (const auto& result : results) {
-        response_json.push_back({
-            {"timestamp", result.timestamp},
-            {"open", result.open},
-            {"close", result.close},
-            {"high", result.high},
-            {"low", result.low},
-            {"volume", result.volume},
-            {"turnover",result.turnover},
-            {"buy", result.buy},
-            {"sell", result.sell}
+        json varied = json::object();
+        for (const auto& name : grid.names()) {
+            varied[name] = result.params.at(name);
+        }
+        if (!result.ok) {
+            results_json.push_back({ {"parameters", varied}, {"error", result.error} });
+            continue;
+        }
+        results_json.push_back({
+            {"parameters", varied},
+            {"pnl", result.summary.pnl},
+            {"return_percent", result.summary.return_percent},
+            {"max_drawdown", result.summary.max_drawdown},
+            {"trades", result.summary.trades},
+            {"winning_trades", result.summary.winning_trades},
+            {"final_equity", result.summary.final_equity}
             });
     }
 
+    json response_json;
+    response_json["combinations"] = grid.size();
+    response_json["results"] = results_json;
+
+    res.result(http::status::ok);
+    res.set(http::field::content_type, "application/json");
+    res.body() = response_json.dump();
+    res.prepare_payload();
+}
+
+// Сводка пакетного бэктеста в ответе /batch_backtest
+json backtest_aggregate_json(const BacktestAggregate& aggregate) {
+    return {
+        {"jobs", aggregate.jobs},
+        {"failed", aggregate.failed},
+        {"mean_return", aggregate.mean_return},
+        {"median_return", aggregate.median_return},
+        {"min_return", aggregate.min_return},
+        {"max_return", aggregate.max_return},
+        {"stdev_return", aggregate.stdev_return},
+        {"profitable_share", aggregate.profitable_share},
+        {"mean_max_drawdown", aggregate.mean_max_drawdown},
+        {"worst_max_drawdown", aggregate.worst_max_drawdown},
+        {"trades", aggregate.trades},
+        {"winning_trades", aggregate.winning_trades}
+    };
+}
+
+void handle_batch_backtest(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    RequestParams params(req.body());
+
+    if (!params.contains("user_id") || !params.contains("strategy_id") || !params.contains("broker_id") ||
+        (!params.contains("jobs") && !params.contains("walk_forward"))) {
+        res.result(http::status::bad_request);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Missing required parameters: user_id, strategy_id, broker_id, and jobs or walk_forward.";
+        return;
+    }
+
+    int user_id;
+    int strategy_id;
+    int broker_id;
+    std::vector<BacktestJob> jobs;
+    try {
+        user_id = params.get_int("user_id");
+        strategy_id = params.get_int("strategy_id");
+        broker_id = params.get_int("broker_id");
+
+        std::map<std::string, std::string> strategy_params = params.strategy_params();
+        if (const json* jobs_json = params.json_value("jobs")) {
+            BatchBacktest::add_jobs(jobs_json->is_string() ? json::parse(jobs_json->get_ref<const std::string&>()) : *jobs_json,
+                strategy_params, jobs);
+        }
+        if (const json* walk_json = params.json_value("walk_forward")) {
+            BatchBacktest::add_walk_forward(walk_json->is_string() ? json::parse(walk_json->get_ref<const std::string&>()) : *walk_json,
+                strategy_params, jobs);
+        }
+        if (jobs.empty()) {
+            throw std::invalid_argument("No backtest jobs");
+        }
+        // Неверные параметры любого задания отклоняем до расчёта
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            try {
+                StrategyFactory::getInstance().validate(strategy_id, jobs[i].params);
+            }
+            catch (const InvalidParams& e) {
+                throw InvalidParams("job " + std::to_string(i) + ": " + e.what());
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        res.result(http::status::bad_request);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Invalid parameter format: " + std::string(e.what());
+        return;
+    }
+
+    BatchBacktestResult batch;
+    try {
+        batch = bot_handler.start_batch_backtest(user_id, strategy_id, broker_id, jobs);
+    }
+    catch (const std::exception& e) {
+        res.result(http::status::internal_server_error);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Error: " + std::string(e.what());
+        return;
+    }
+
+    json results_json = json::array();
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const BacktestJobResult& result = batch.results[i];
+        json item = {
+            {"symbol", jobs[i].symbol},
+            {"start_date", std::to_string(jobs[i].start)},
+            {"end_date", std::to_string(jobs[i].end)}
+        };
+        if (!result.ok) {
+            item["error"] = result.error;
+        }
+        else {
+            item["candles"] = result.candles;
+            item["pnl"] = result.summary.pnl;
+            item["return_percent"] = result.summary.return_percent;
+            item["max_drawdown"] = result.summary.max_drawdown;
+            item["trades"] = result.summary.trades;
+            item["winning_trades"] = result.summary.winning_trades;
+            item["final_equity"] = result.summary.final_equity;
+        }
+        results_json.push_back(std::move(item));
+    }
+
+    json by_symbol = json::object();
+    for (const auto& item : batch.by_symbol) {
+        by_symbol[item.first] = backtest_aggregate_json(item.second);
+    }
+
+    json response_json;
+    response_json["jobs"] = jobs.size();
+    response_json["candle_windows"] = batch.candle_windows;
+    response_json["summary"] = backtest_aggregate_json(batch.total);
+    response_json["by_symbol"] = by_symbol;
+    response_json["results"] = results_json;
+
     res.result(http::status::ok);
     res.set(http::field::content_type, "application/json");
     res.body() = response_json.dump();
@@ -120,12 +335,12 @@ void handle_execute_historical(http::request<http::string_body>& req, http::resp
 
 void handle_start(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
     // Парсим JSON из тела запроса
-    auto params = parse_json_body(req.body());
+    RequestParams params(req.body());
 
     // Проверяем обязательные параметры
-    if (params.find("user_id") == params.end() || params.find("bot_id") == params.end() ||
-        params.find("strategy_id") == params.end() || params.find("broker_id") == params.end()
-        || params.find("money") == params.end() || params.find("symbol") == params.end()
+    if (!params.contains("user_id") || !params.contains("bot_id") ||
+        !params.contains("strategy_id") || !params.contains("broker_id")
+        || !params.contains("money") || !params.contains("symbol")
         ) {
         res.result(http::status::bad_request);
         res.set(http::field::content_type, "text/plain");
@@ -134,37 +349,28 @@ void handle_start(http::request<http::string_body>& req, http::response<http::st
     }
 
     try {
-        int user_id = std::stoi(params["user_id"]);
-        std::string symbol = params["symbol"];
+        int user_id = params.get_int("user_id");
+        std::string symbol(params["symbol"]);
 
-        int bot_id = std::stoi(params["bot_id"]);
-        int strategy_id = std::stoi(params["strategy_id"]);
-        int broker_id = std::stoi(params["broker_id"]);
-        std::string money = params["money"];
+        int bot_id = params.get_int("bot_id");
+        int strategy_id = params.get_int("strategy_id");
+        int broker_id = params.get_int("broker_id");
+        std::string money(params["money"]);
 
         // Параметры стратегии (если есть)
-        std::map<std::string, std::string> strategy_params;
-        if (params.find("strategy_parameters") != params.end()) {
-            auto strategy_params_json = json::parse(params["strategy_parameters"]);
-            if (strategy_params_json.is_object()) {
-                for (auto it = strategy_params_json.begin(); it != strategy_params_json.end(); ++it) {
-                    const std::string& key = it.key();
-                    const auto& value = it.value();
-
-                    if (value.is_string()) {
-                        strategy_params[key] = value.get<std::string>();
-                    }
-                    else {
-                        strategy_params[key] = value.dump(); // Преобразуем в строку, если это не строка
-                    }
-                }
-            }
-        }
+        std::map<std::string, std::string> strategy_params = params.strategy_params();
         strategy_params["money"] = money;
         strategy_params["symbol"] = symbol;
+        // Неверные параметры отклоняем до запуска бота
+        StrategyFactory::getInstance().validate(strategy_id, strategy_params);
 
         // Запуск бота
-        bot_handler.start_bot(user_id, bot_id, strategy_id, broker_id, strategy_params);
+        if (!bot_handler.start_bot(user_id, bot_id, strategy_id, broker_id, strategy_params)) {
+            res.result(http::status::internal_server_error);
+            res.set(http::field::content_type, "text/plain");
+            res.body() = "Bot " + std::to_string(bot_id) + " could not be started.";
+            return;
+        }
 
         res.result(http::status::ok);
         res.set(http::field::content_type, "text/plain");
@@ -179,10 +385,10 @@ void handle_start(http::request<http::string_body>& req, http::response<http::st
 
 void handle_stop(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
     // Парсим JSON из тела запроса
-    auto params = parse_json_body(req.body());
+    RequestParams params(req.body());
 
     // Проверяем обязательные параметры
-    if (params.find("bot_id") == params.end()) {
+    if (!params.contains("bot_id")) {
         res.result(http::status::bad_request);
         res.set(http::field::content_type, "text/plain");
         res.body() = "Missing required parameter: bot_id.";
@@ -190,7 +396,7 @@ void handle_stop(http::request<http::string_body>& req, http::response<http::str
     }
 
     try {
-        int bot_id = std::stoi(params["bot_id"]);
+        int bot_id = params.get_int("bot_id");
 
         bot_handler.stop_bot(bot_id);
             res.result(http::status::ok);
@@ -206,11 +412,11 @@ void handle_stop(http::request<http::string_body>& req, http::response<http::str
 }
 void handle_update(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
     // Парсим JSON из тела запроса
-    auto params = parse_json_body(req.body());
+    RequestParams params(req.body());
 
     // Проверяем обязательные параметры
-    if (params.find("user_id") == params.end() || params.find("bot_id") == params.end() ||
-        params.find("strategy_id") == params.end() || params.find("broker_id") == params.end()) {
+    if (!params.contains("user_id") || !params.contains("bot_id") ||
+        !params.contains("strategy_id") || !params.contains("broker_id")) {
         res.result(http::status::bad_request);
         res.set(http::field::content_type, "text/plain");
         res.body() = "Missing required parameters: user_id, bot_id, strategy_id, or broker_id.";
@@ -218,34 +424,19 @@ void handle_update(http::request<http::string_body>& req, http::response<http::s
     }
 
     try {
-        int user_id = std::stoi(params["user_id"]);
-        int bot_id = std::stoi(params["bot_id"]);
-        int strategy_id = std::stoi(params["strategy_id"]);
-        int broker_id = std::stoi(params["broker_id"]);
-        std::string money = params["money"];
-        std::string symbol = params["money"];
+        int user_id = params.get_int("user_id");
+        int bot_id = params.get_int("bot_id");
+        int strategy_id = params.get_int("strategy_id");
+        int broker_id = params.get_int("broker_id");
+        std::string money(params["money"]);
+        std::string symbol(params["money"]);
 
         // Параметры стратегии (если есть)
-        std::map<std::string, std::string> strategy_params;
-        if (params.find("strategy_parameters") != params.end()) {
-            auto strategy_params_json = json::parse(params["strategy_parameters"]);
-            if (strategy_params_json.is_object()) {
-                for (auto it = strategy_params_json.begin(); it != strategy_params_json.end(); ++it) {
-                    const std::string& key = it.key();
-                    const auto& value = it.value();
-
-                    if (value.is_string()) {
-                        strategy_params[key] = value.get<std::string>();
-                    }
-                    else {
-                        strategy_params[key] = value.dump(); // Преобразуем в строку, если это не строка
-                    }
-                }
-            }
-        }
+        std::map<std::string, std::string> strategy_params = params.strategy_params();
         strategy_params["money"] = money;
         strategy_params["symbol"] = symbol;
-
+        // Работающий бот не останавливаем, если новые параметры неверны
+        StrategyFactory::getInstance().validate(strategy_id, strategy_params);
 
         bot_handler.stop_bot(bot_id);
 
@@ -264,13 +455,13 @@ void handle_update(http::request<http::string_body>& req, http::response<http::s
 void handle_analyze(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
     try {
         // Парсим JSON из тела запроса
-        auto params = parse_json_body(req.body());
+        RequestParams params(req.body());
 
         // Проверяем наличие обязательных параметров
-        if (params.find("start_date") == params.end() ||
-            params.find("end_date") == params.end() ||
-            params.find("market_type_name") == params.end() ||
-            params.find("symbol") == params.end()) {
+        if (!params.contains("start_date") ||
+            !params.contains("end_date") ||
+            !params.contains("market_type_name") ||
+            !params.contains("symbol")) {
 
             res.result(http::status::bad_request);
             res.set(http::field::content_type, "application/json");
@@ -280,10 +471,10 @@ void handle_analyze(http::request<http::string_body>& req, http::response<http::
             return;
         }
 
-        std::string start_date = params["start_date"];
-        std::string end_date = params["end_date"];
-        std::string symbol = params["symbol"];
-        std::string market_type_name = params["market_type_name"];
+        std::string start_date(params["start_date"]);
+        std::string end_date(params["end_date"]);
+        std::string symbol(params["symbol"]);
+        std::string market_type_name(params["market_type_name"]);
 
         std::shared_ptr<Informer> informer;
         if (market_type_name == "Crypto") {
@@ -338,17 +529,17 @@ void handle_analyze(http::request<http::string_body>& req, http::response<http::
         res.prepare_payload();
     }
 }
-void handle_data_historical(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+void handle_data_historical(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler, ResponseStream& stream) {
     try {
         // Парсим JSON из тела запроса
-        auto params = parse_json_body(req.body());
+        RequestParams params(req.body());
 
         // Проверяем наличие обязательных параметров
-        if (params.find("start_date") == params.end() ||
-            params.find("end_date") == params.end() ||
-            params.find("market_type_name") == params.end() ||
-            params.find("symbol") == params.end() ||
-            params.find("interval") == params.end()) {  // Исправлено: interval вместо intreval
+        if (!params.contains("start_date") ||
+            !params.contains("end_date") ||
+            !params.contains("market_type_name") ||
+            !params.contains("symbol") ||
+            !params.contains("interval")) {  // Исправлено: interval вместо intreval
 
             res.result(http::status::bad_request);
             res.set(http::field::content_type, "application/json");
@@ -358,11 +549,11 @@ void handle_data_historical(http::request<http::string_body>& req, http::respons
             return;
         }
 
-        std::string start_date = params["start_date"];
-        std::string end_date = params["end_date"];
-        std::string symbol = params["symbol"];
-        std::string market_type_name = params["market_type_name"];
-        std::string interval = params["interval"];
+        std::string start_date(params["start_date"]);
+        std::string end_date(params["end_date"]);
+        std::string symbol(params["symbol"]);
+        std::string market_type_name(params["market_type_name"]);
+        std::string interval(params["interval"]);
 
         // Проверка на пустые значения
         if (start_date.empty() || end_date.empty() || symbol.empty() || interval.empty()) {
@@ -402,35 +593,44 @@ void handle_data_historical(http::request<http::string_body>& req, http::respons
 
 
         // Получаем исторические данные
-        std::vector<CandleData> result = informer->get_symbol_historical(symbol, start_date, end_date, interval);
-        std::sort(result.begin(), result.end(), [](const CandleData& a, const CandleData& b) {
-            return a.timestamp < b.timestamp;
-            });
-        // Преобразуем CandleData в JSON
-        json candles_json = json::array();
-        for (const auto& candle : result) {
-            candles_json.push_back({
-                {"timestamp", candle.timestamp},
-                {"open", candle.open},
-                {"close", candle.close},
-                {"high", candle.high},
-                {"low", candle.low},
-                {"volume", candle.volume}
-                });
-        }
-
-        // Формируем JSON-ответ
-        json response_json;
-        response_json["result"] = candles_json;
+        auto result = std::make_shared<CandleSeries>(
+            CandleCache::getInstance().get_symbol_historical(informer, symbol, start_date, end_date, interval));
 
+        const bool columnar = wants_columnar(req);
         res.result(http::status::ok);
-        res.set(http::field::content_type, "application/json");
-        res.body() = response_json.dump();
-        res.prepare_payload();
+        res.set(http::field::content_type, columnar ? ColumnarWriter::content_type : "application/json");
+
+        // {"result": [...]} пишется частями, без промежуточного JSON-дерева на весь период
+        stream.start([result, columnar](ChunkedWriter& out) {
+            if (columnar) {
+                ColumnarWriter writer(out, ColumnarWriter::Kind::Candles);
+                for (size_t i = 0; i < result->size(); ++i) {
+                    writer.add_row(result->timestamp(i), result->open()[i], result->high()[i], result->low()[i],
+                        result->close()[i], result->volume()[i], result->turnover()[i]);
+                }
+                writer.finish();
+                return;
+            }
+            static const std::string head = "{\"result\":[";
+            bool first = true;
+            out.write(head);
+            for (size_t i = 0; i < result->size(); ++i) {
+                // Время по-прежнему строкой в миллисекундах
+                write_array_item(out, first, {
+                    {"timestamp", std::to_string(result->timestamp(i))},
+                    {"open", result->open()[i]},
+                    {"close", result->close()[i]},
+                    {"high", result->high()[i]},
+                    {"low", result->low()[i]},
+                    {"volume", result->volume()[i]}
+                    });
+            }
+            out.write("]}", 2);
+            });
     }
     catch (const std::exception& e) {
         // Логируем ошибку
-        std::cerr << "Error in handle_data_historical: " << e.what() << std::endl;
+        log_error() << "Error in handle_data_historical: " << e.what();
 
         res.result(http::status::internal_server_error);
         res.set(http::field::content_type, "application/json");
@@ -441,10 +641,10 @@ void handle_data_historical(http::request<http::string_body>& req, http::respons
 }
 void handle_continue(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
     // Парсим JSON из тела запроса
-    auto params = parse_json_body(req.body());
+    RequestParams params(req.body());
 
     // Проверяем обязательные параметры
-    if (params.find("bot_id") == params.end()) {
+    if (!params.contains("bot_id")) {
         res.result(http::status::bad_request);
         res.set(http::field::content_type, "text/plain");
         res.body() = "Missing required parameter: bot_id.";
@@ -452,7 +652,7 @@ void handle_continue(http::request<http::string_body>& req, http::response<http:
     }
 
     try {
-        int bot_id = std::stoi(params["bot_id"]);
+        int bot_id = params.get_int("bot_id");
 
         // Продолжаем работу бота
         bot_handler.initialize_single_bot(bot_id);
@@ -467,8 +667,249 @@ void handle_continue(http::request<http::string_body>& req, http::response<http:
         res.body() = "Invalid parameter format: " + std::string(e.what());
     }
 }
- 
-void handle_request(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler, const boost::asio::ip::tcp::endpoint& client_endpoint) {
+// Счётчики кэша свечей
+void handle_cache_stats(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    CandleCacheStats stats = CandleCache::getInstance().get_stats();
+
+    json response_json;
+    response_json["hits"] = stats.hits;
+    response_json["partial_hits"] = stats.partial_hits;
+    response_json["misses"] = stats.misses;
+    response_json["fetched_candles"] = stats.fetched_candles;
+    response_json["evictions"] = stats.evictions;
+    response_json["cached_candles"] = stats.cached_candles;
+    response_json["series"] = stats.series;
+
+    res.result(http::status::ok);
+    res.set(http::field::content_type, "application/json");
+    res.body() = response_json.dump();
+    res.prepare_payload();
+}
+
+// Счётчики пула соединений MySQL, отложенной записи цен и записи сделок
+void handle_db_pool_stats(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    ConnectionPoolStats stats = ConnectionPool::getInstance().get_stats();
+
+    json response_json;
+    response_json["max_size"] = stats.max_size;
+    response_json["open"] = stats.open;
+    response_json["idle"] = stats.idle;
+    response_json["in_use"] = stats.in_use;
+    response_json["acquired"] = stats.acquired;
+    response_json["waited"] = stats.waited;
+    response_json["wait_time_us"] = stats.wait_time_us;
+    response_json["exhausted"] = stats.exhausted;
+    response_json["created"] = stats.created;
+    response_json["reconnects"] = stats.reconnects;
+
+    PriceUpdateQueue& prices = PriceUpdateQueue::getInstance();
+    response_json["price_updates"] = {
+        {"pending", prices.pending()},
+        {"enqueued", prices.enqueued()},
+        {"flushed_rows", prices.flushed_rows()},
+        {"statements", prices.statements()}
+    };
+
+    TradeCommitStats& trades = Broker::commitStats();
+    LatencySnapshot latency = trades.latency.snapshot();
+    response_json["trade_commits"] = {
+        {"count", latency.count},
+        {"retries", trades.retries.load()},
+        {"failures", trades.failures.load()},
+        {"p50_us", latency.p50_us},
+        {"p90_us", latency.p90_us},
+        {"p99_us", latency.p99_us},
+        {"max_us", latency.max_us}
+    };
+
+    res.result(http::status::ok);
+    res.set(http::field::content_type, "application/json");
+    res.body() = response_json.dump();
+    res.prepare_payload();
+}
+
+// Счётчики кэша брокеров и типов рынков
+json broker_cache_stats_json() {
+    BrokerMetadataStats stats = BrokerMetadataCache::getInstance().get_stats();
+    json response_json;
+    response_json["version"] = stats.version;
+    response_json["brokers"] = stats.brokers;
+    response_json["refreshes"] = stats.refreshes;
+    response_json["failures"] = stats.failures;
+    response_json["age_ms"] = stats.age_ms;
+    return response_json;
+}
+
+void handle_broker_cache_stats(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    res.result(http::status::ok);
+    res.set(http::field::content_type, "application/json");
+    res.body() = broker_cache_stats_json().dump();
+    res.prepare_payload();
+}
+
+// Перечитать брокеров и типы рынков после изменения таблиц, не дожидаясь TTL
+void handle_broker_cache_refresh(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    bool refreshed = BrokerMetadataCache::getInstance().refresh();
+    json response_json = broker_cache_stats_json();
+    response_json["refreshed"] = refreshed;
+
+    res.result(refreshed ? http::status::ok : http::status::service_unavailable);
+    res.set(http::field::content_type, "application/json");
+    res.body() = response_json.dump();
+    res.prepare_payload();
+}
+
+// Фоновая догрузка периода в архив свечей на диске
+void handle_archive_backfill(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    try {
+        RequestParams params(req.body());
+        std::string start_date(params["start_date"]);
+        std::string end_date(params["end_date"]);
+        std::string symbol(params["symbol"]);
+        std::string market_type_name(params["market_type_name"]);
+        std::string interval(params["interval"]);
+
+        res.set(http::field::content_type, "application/json");
+        if (start_date.empty() || end_date.empty() || symbol.empty() || market_type_name.empty() || interval.empty()) {
+            res.result(http::status::bad_request);
+            res.body() = json({ {"error", "Missing required parameters: start_date, end_date, market_type_name, symbol, or interval."} }).dump();
+            res.prepare_payload();
+            return;
+        }
+        if (!CandleArchive::getInstance().enabled() || TimeUtils::interval_seconds(interval) == 0) {
+            res.result(http::status::bad_request);
+            res.body() = json({ {"error", "Candle archive is disabled or the interval is not supported."} }).dump();
+            res.prepare_payload();
+            return;
+        }
+
+        std::shared_ptr<Informer> informer;
+        if (market_type_name == "Crypto") {
+            informer = std::make_shared<ByBitInformer>();
+        }
+        else if (market_type_name == "Stocks") {
+            informer = std::make_shared<TinkoffInformer>(Constants::tinkoff_token);
+        }
+        else if (market_type_name == "Forex") {
+            informer = std::make_shared<YahooForexInformer>();
+        }
+        else {
+            res.result(http::status::bad_request);
+            res.body() = json({ {"error", "Invalid market_type_name. Supported: Crypto, Stocks, Forex."} }).dump();
+            res.prepare_payload();
+            return;
+        }
+
+        size_t queued = CandleBackfill::getInstance().enqueue(informer, symbol, interval,
+            std::stoll(start_date), std::stoll(end_date));
+        res.result(http::status::accepted);
+        res.body() = json({ {"queued", queued} }).dump();
+        res.prepare_payload();
+    }
+    catch (const std::exception& e) {
+        res.result(http::status::bad_request);
+        res.set(http::field::content_type, "text/plain");
+        res.body() = "Invalid parameter format: " + std::string(e.what());
+    }
+}
+
+// Счётчики архива свечей и фоновой догрузки
+void handle_archive_stats(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    CandleArchiveStats stats = CandleArchive::getInstance().get_stats();
+    CandleBackfillStats backfill = CandleBackfill::getInstance().get_stats();
+
+    json response_json;
+    response_json["enabled"] = CandleArchive::getInstance().enabled();
+    response_json["hits"] = stats.hits;
+    response_json["partial_hits"] = stats.partial_hits;
+    response_json["misses"] = stats.misses;
+    response_json["bypassed"] = stats.bypassed;
+    response_json["fetched_candles"] = stats.fetched_candles;
+    response_json["archived_candles"] = stats.archived_candles;
+    response_json["series"] = stats.series;
+    response_json["backfill"] = {
+        {"queued", backfill.queued},
+        {"running", backfill.running},
+        {"completed", backfill.completed},
+        {"incomplete", backfill.incomplete},
+        {"candles", backfill.candles}
+    };
+
+    res.result(http::status::ok);
+    res.set(http::field::content_type, "application/json");
+    res.body() = response_json.dump();
+    res.prepare_payload();
+}
+
+// Метрики процесса в текстовом формате Prometheus
+void handle_metrics(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler) {
+    res.result(http::status::ok);
+    res.set(http::field::content_type, "text/plain; version=0.0.4; charset=utf-8");
+    res.body() = Metrics::getInstance().render();
+    res.prepare_payload();
+}
+
+// Ряды /metrics из счётчиков, которые уже ведут BotHandler и кэши свечей
+void register_metrics(BotHandler& bot_handler) {
+    Metrics& metrics = Metrics::getInstance();
+    metrics.callback("tradesnake_active_bots", "Bots running in the live trading loop", "gauge", {},
+        [&bot_handler]() { return static_cast<double>(bot_handler.active_bot_count()); });
+    const std::string warmup_help = "Bots queued, started and failed during the bulk startup at launch";
+    metrics.callback("tradesnake_bot_warmup_bots", warmup_help, "gauge", { {"state", "total"} },
+        [&bot_handler]() { return static_cast<double>(bot_handler.warmup_progress().total); });
+    metrics.callback("tradesnake_bot_warmup_bots", warmup_help, "gauge", { {"state", "started"} },
+        [&bot_handler]() { return static_cast<double>(bot_handler.warmup_progress().started); });
+    metrics.callback("tradesnake_bot_warmup_bots", warmup_help, "gauge", { {"state", "failed"} },
+        [&bot_handler]() { return static_cast<double>(bot_handler.warmup_progress().failed); });
+
+    const std::string cache_help = "Candle cache requests by result";
+    metrics.callback("tradesnake_candle_cache_requests_total", cache_help, "counter", { {"result", "hit"} },
+        []() { return static_cast<double>(CandleCache::getInstance().get_stats().hits); });
+    metrics.callback("tradesnake_candle_cache_requests_total", cache_help, "counter", { {"result", "partial_hit"} },
+        []() { return static_cast<double>(CandleCache::getInstance().get_stats().partial_hits); });
+    metrics.callback("tradesnake_candle_cache_requests_total", cache_help, "counter", { {"result", "miss"} },
+        []() { return static_cast<double>(CandleCache::getInstance().get_stats().misses); });
+    metrics.callback("tradesnake_candle_cache_candles", "Candles held in the in-memory candle cache", "gauge", {},
+        []() { return static_cast<double>(CandleCache::getInstance().get_stats().cached_candles); });
+
+    const std::string archive_help = "On-disk candle archive requests by result";
+    metrics.callback("tradesnake_candle_archive_requests_total", archive_help, "counter", { {"result", "hit"} },
+        []() { return static_cast<double>(CandleArchive::getInstance().get_stats().hits); });
+    metrics.callback("tradesnake_candle_archive_requests_total", archive_help, "counter", { {"result", "partial_hit"} },
+        []() { return static_cast<double>(CandleArchive::getInstance().get_stats().partial_hits); });
+    metrics.callback("tradesnake_candle_archive_requests_total", archive_help, "counter", { {"result", "miss"} },
+        []() { return static_cast<double>(CandleArchive::getInstance().get_stats().misses); });
+    metrics.callback("tradesnake_candle_archive_requests_total", archive_help, "counter", { {"result", "bypassed"} },
+        []() { return static_cast<double>(CandleArchive::getInstance().get_stats().bypassed); });
+
+    metrics.callback("tradesnake_broker_cache_brokers", "Brokers in the current broker metadata snapshot", "gauge", {},
+        []() { return static_cast<double>(BrokerMetadataCache::getInstance().get_stats().brokers); });
+    const std::string broker_cache_help = "Broker metadata reloads by result";
+    metrics.callback("tradesnake_broker_cache_refreshes_total", broker_cache_help, "counter", { {"result", "ok"} },
+        []() { return static_cast<double>(BrokerMetadataCache::getInstance().get_stats().refreshes); });
+    metrics.callback("tradesnake_broker_cache_refreshes_total", broker_cache_help, "counter", { {"result", "failed"} },
+        []() { return static_cast<double>(BrokerMetadataCache::getInstance().get_stats().failures); });
+
+    metrics.callback("tradesnake_log_dropped_total", "Log records dropped because the log queue was full", "counter", {},
+        []() { return static_cast<double>(Logger::getInstance().dropped()); });
+    metrics.callback("tradesnake_log_suppressed_total", "Repeated warnings and errors suppressed by the log rate limit", "counter", {},
+        []() { return static_cast<double>(Logger::getInstance().suppressed()); });
+}
+
+// Ряд задержки маршрута; неизвестные пути собираются в один ряд "other"
+ShardedHistogram& route_latency(const http::request<http::string_body>& req) {
+    static const std::set<std::string> routes = {
+        "/execute_historical", "/optimize", "/batch_backtest", "/start", "/historical_data", "/continue", "/stop", "/analyze",
+        "/update", "/cache_stats", "/db_pool_stats", "/archive_backfill", "/archive_stats", "/metrics",
+        "/broker_cache_stats", "/broker_cache_refresh"
+    };
+    std::string target(req.target());
+    return Metrics::getInstance().histogram("tradesnake_http_request_duration_seconds",
+        "HTTP request handling time by route (for streamed responses - until the stream starts)",
+        { {"route", routes.count(target) ? target : "other"} });
+}
+
+void handle_request(http::request<http::string_body>& req, http::response<http::string_body>& res, BotHandler& bot_handler, const boost::asio::ip::tcp::endpoint& client_endpoint, ResponseStream& stream) {
     if (!is_allowed_ip(client_endpoint)) {
         res.result(http::status::forbidden);
         res.set(http::field::content_type, "text/plain");
@@ -476,15 +917,23 @@ void handle_request(http::request<http::string_body>& req, http::response<http::
         return;
     }
 
+    ScopedTimer timer(route_latency(req));
+    RequestArena arena; // разобранные параметры запроса; освобождается целиком по выходу из обработчика
     try {
         if (req.target() == "/execute_historical" && req.method() == http::verb::post) {
-            handle_execute_historical(req, res, bot_handler);
+            handle_execute_historical(req, res, bot_handler, stream);
+        }
+        else if (req.target() == "/optimize" && req.method() == http::verb::post) {
+            handle_optimize(req, res, bot_handler);
+        }
+        else if (req.target() == "/batch_backtest" && req.method() == http::verb::post) {
+            handle_batch_backtest(req, res, bot_handler);
         }
         else if (req.target() == "/start" && req.method() == http::verb::post) {
             handle_start(req, res, bot_handler);
         }
         else if (req.target() == "/historical_data" && req.method() == http::verb::post) {
-            handle_data_historical(req, res, bot_handler);
+            handle_data_historical(req, res, bot_handler, stream);
         }
         else if (req.target() == "/continue" && req.method() == http::verb::post) {
             handle_continue(req, res, bot_handler);
@@ -498,6 +947,27 @@ void handle_request(http::request<http::string_body>& req, http::response<http::
         else if (req.target() == "/update" && req.method() == http::verb::post) {
             handle_update(req, res, bot_handler);
         }
+        else if (req.target() == "/cache_stats" && req.method() == http::verb::get) {
+            handle_cache_stats(req, res, bot_handler);
+        }
+        else if (req.target() == "/db_pool_stats" && req.method() == http::verb::get) {
+            handle_db_pool_stats(req, res, bot_handler);
+        }
+        else if (req.target() == "/archive_backfill" && req.method() == http::verb::post) {
+            handle_archive_backfill(req, res, bot_handler);
+        }
+        else if (req.target() == "/archive_stats" && req.method() == http::verb::get) {
+            handle_archive_stats(req, res, bot_handler);
+        }
+        else if (req.target() == "/broker_cache_stats" && req.method() == http::verb::get) {
+            handle_broker_cache_stats(req, res, bot_handler);
+        }
+        else if (req.target() == "/broker_cache_refresh" && req.method() == http::verb::post) {
+            handle_broker_cache_refresh(req, res, bot_handler);
+        }
+        else if (req.target() == "/metrics" && req.method() == http::verb::get) {
+            handle_metrics(req, res, bot_handler);
+        }
  
         else {
             res.result(http::status::not_found);
@@ -506,45 +976,89 @@ void handle_request(http::request<http::string_body>& req, http::response<http::
         }
     }
     catch (const std::exception& e) {
+        stream.reset();
         res.result(http::status::internal_server_error);
         res.set(http::field::content_type, "text/plain");
         res.body() = "Error: " + std::string(e.what());
     }
 }
 
+// Маршруты, которые выполняются в пуле обработчиков, а не на потоках ввода-вывода
+bool is_heavy_route(const http::request<http::string_body>& req) {
+    return req.target() == "/execute_historical" ||
+        req.target() == "/optimize" ||
+        req.target() == "/batch_backtest" ||
+        req.target() == "/historical_data" ||
+        req.target() == "/analyze" ||
+        req.target() == "/broker_cache_refresh";
+}
+
+// Размер пула из переменной окружения (или значение по умолчанию)
+unsigned int get_pool_size(const char* env_name, unsigned int default_size) {
+    const char* value = std::getenv(env_name);
+    if (value != nullptr) {
+        try {
+            int size = std::stoi(value);
+            if (size > 0) return static_cast<unsigned int>(size);
+        }
+        catch (const std::exception&) {
+            log_warn() << "Invalid value of " << env_name << ": " << value;
+        }
+    }
+    return std::max(1u, default_size);
+}
+
 // Запуск сервера
 void run_server() {
     try {
-        net::io_context ioc;
-        tcp::acceptor acceptor(ioc, tcp::endpoint(tcp::v4(), 9090));
+        const unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned int io_threads = get_pool_size("TRADESNAKE_IO_THREADS", std::min(cores, 4u));
+        const unsigned int worker_threads = get_pool_size("TRADESNAKE_WORKER_THREADS", cores);
+        // Потоковые ответы держат поток пула, пока клиент читает; хотя бы один поток остаётся остальным запросам
+        const unsigned int max_streams = std::min(get_pool_size("TRADESNAKE_MAX_STREAMS", worker_threads / 2),
+            std::max(1u, worker_threads - 1));
+
+        net::io_context ioc(static_cast<int>(io_threads));
+        net::thread_pool workers(worker_threads);
 
         BotHandler bot_handler;
+        register_metrics(bot_handler);
         bot_handler.initialize_bots();
 
-        std::cout << "Server is running on port 9090..." << std::endl;
-
-        while (true) {
-            tcp::socket socket(ioc);
-            acceptor.accept(socket);
-
-            // Получаем IP-адрес клиента
-            boost::asio::ip::tcp::endpoint client_endpoint = socket.remote_endpoint();
-
-            beast::flat_buffer buffer;
-            http::request<http::string_body> req;
-            http::read(socket, buffer, req);
+        auto listener = std::make_shared<HttpListener>(
+            ioc,
+            tcp::endpoint(tcp::v4(), 9090),
+            [&bot_handler](http::request<http::string_body>& req, http::response<http::string_body>& res, const tcp::endpoint& client_endpoint, ResponseStream& stream) {
+                handle_request(req, res, bot_handler, client_endpoint, stream);
+            },
+            is_heavy_route,
+            workers,
+            max_streams);
+        listener->run();
+
+        // Корректное завершение по SIGINT/SIGTERM
+        net::signal_set signals(ioc, SIGINT, SIGTERM);
+        signals.async_wait([&ioc](const beast::error_code&, int) {
+            ioc.stop();
+            });
 
-            http::response<http::string_body> res;
+        log_info() << "Server is running on port 9090 (" << io_threads << " I/O threads, "
+            << worker_threads << " worker threads, up to " << max_streams << " streaming responses)...";
 
-            // Обработка запроса
-            handle_request(req, res, bot_handler, client_endpoint);
+        std::vector<std::thread> io_pool;
+        io_pool.reserve(io_threads - 1);
+        for (unsigned int i = 1; i < io_threads; ++i) {
+            io_pool.emplace_back([&ioc]() { ioc.run(); });
+        }
+        ioc.run();
 
-            http::write(socket, res);
-            socket.shutdown(tcp::socket::shutdown_both);
+        for (auto& thread : io_pool) {
+            thread.join();
         }
+        workers.join();
     }
     catch (const std::exception& e) {
-        std::cerr << "Error in server: " << e.what() << std::endl;
+        log_error() << "Error in server: " << e.what();
     }
 }
 
@@ -0,0 +1,108 @@
+#ifndef PORTFOLIO_BOT_HPP
+#define PORTFOLIO_BOT_HPP
+
+#include "./TradeBot.hpp"
+#include "../StrategyFactory.hpp"
+#include "../StrategyParams.hpp"
+#include "../Informers/QuoteService.hpp"
+#include "../Utils/Logger.hpp"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// Портфельный бот: одна стратегия на списке символов (параметр symbols) в одной строке bots.
+// По каждому символу создаётся обычный бот стратегии с общими информером и брокером портфеля;
+// шаг портфеля получает цены всех символов одной пачкой (QuoteService::get_symbols_now),
+// прогоняет стратегию по каждому символу и пишет все сделки шага одной транзакцией (Broker::commit)
+// вместе с позициями по символам, которые при перезапуске восстанавливаются из strategy_parameters.
+// Для бэктеста портфель не предназначен: strategy() портфеля ничего не решает.
+class PortfolioBot : public TradeBot {
+public:
+    PortfolioBot(int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams& params)
+        : TradeBot(user_id, bot_id, strategy_id, broker_id, params) {
+        const PortfolioParams& portfolio = strategy_params<PortfolioParams>();
+        symbols_ = portfolio.symbols;
+
+        // Боты символов не ходят в БД: информер и брокер у всех общие с портфелем
+        BacktestResources shared{ informer, broker };
+        BacktestResources::Scope scope(shared);
+        members_.reserve(symbols_.size());
+        for (const auto& member_symbol : symbols_) {
+            members_.push_back(std::shared_ptr<TradeBot>(StrategyFactory::getInstance().createStrategy(
+                strategy_id, user_id, bot_id, broker_id, portfolio.member_params(params.raw(), member_symbol))));
+        }
+    }
+
+    void tick() override {
+        if (!is_running.load()) return;
+
+        std::map<std::string, double> prices = QuoteService::getInstance().get_symbols_now(informer, symbols_);
+        // evaluate сразу меняет позиции символов; если шаг не дошёл до БД (исключение в стратегии любого
+        // символа или в транзакции, либо транзакция не прошла), все они возвращаются к записанным в БД
+        std::vector<BotBalance> saved;
+        saved.reserve(members_.size());
+        for (const auto& member : members_) saved.push_back(member->save_balance());
+
+        std::vector<TradeOrder> orders;
+        bool committed = true;
+        try {
+            for (size_t i = 0; i < members_.size(); ++i) {
+                auto price = prices.find(symbols_[i]);
+                if (price == prices.end()) {
+                    log_warn().symbol(symbols_[i]) << "Portfolio bot " << bot_id << " skipped " << symbols_[i] << ": no price.";
+                    continue;
+                }
+                TradeOrder order;
+                // Сделки нет - символ ничего не пишет: текущая цена в строке bots у портфеля одна на все символы
+                if (members_[i]->evaluate(price->second, order) && order.type_id != 0) orders.push_back(order);
+            }
+            if (!orders.empty()) committed = broker->commit(bot_id, orders, account());
+        }
+        catch (...) {
+            restore_balances(saved);
+            throw;
+        }
+        if (!committed) {
+            restore_balances(saved);
+            log_error() << "Portfolio bot " << bot_id << " step was not written: " << orders.size()
+                << " trades discarded, positions restored.";
+        }
+    }
+
+    // Цена одного символа портфелю не подходит: цены всех символов он получает сам
+    void tick(double) override { tick(); }
+
+    bool single_symbol() const override { return false; }
+
+    int strategy(double) override { return 0; }
+
+    const std::vector<std::string>& get_symbols() const { return symbols_; }
+
+private:
+    std::vector<std::string> symbols_;
+    std::vector<std::shared_ptr<TradeBot>> members_; // по одному на символ, в порядке symbols_
+
+    void restore_balances(const std::vector<BotBalance>& saved) {
+        for (size_t i = 0; i < members_.size(); ++i) members_[i]->restore_balance(saved[i]);
+    }
+
+    // Счёт после шага: деньги всех символов и позиции по каждому. Количество разных активов не складывается -
+    // bots.symbol_count портфеля всегда 0, количество каждого символа хранится только в позициях
+    PortfolioAccount account() const {
+        PortfolioAccount result{ 0, 0, {} };
+        nlohmann::json positions = nlohmann::json::object();
+        for (size_t i = 0; i < members_.size(); ++i) {
+            result.money += members_[i]->get_money();
+            positions[symbols_[i]] = {
+                {"money", members_[i]->get_money()},
+                {"symbol_count", members_[i]->get_symbol_count()}
+            };
+        }
+        result.positions_json = positions.dump();
+        return result;
+    }
+};
+
+#endif // PORTFOLIO_BOT_HPP
@@ -2,6 +2,7 @@
 #define TRADEBOT_HPP
 
 #include "../Informers/Informer.hpp"
+#include "../Informers/Crypto/ByBitInformer.hpp"
 #include "../Informers/Stocks//TinkoffInformer.hpp"
 #include "../Informers/Forex/YahooInformerForex.hpp"
 #include <chrono>
@@ -16,15 +17,55 @@
 #include "../const.hpp"
 #include <mysql/jdbc.h>
 #include "../Brokers/Broker.hpp"
+#include "../Database/ConnectionPool.hpp"
 #include "../struct.hpp"
+#include "../Cache/CandleCache.hpp"
+#include "../Cache/BrokerMetadataCache.hpp"
+#include "../Data/CandleSeries.hpp"
+#include "../Informers/QuoteService.hpp"
+#include "../Utils/Metrics.hpp"
+#include "../Utils/Logger.hpp"
+#include "../StrategyParams.hpp"
 #include <algorithm>
+#include <cmath>
+#include <utility>
 
-//   TradeBot
+// Информер и брокер, заранее известные создающему ботов коду: общие для всех ботов одного бэктеста
+// или для ботов одного брокера при массовом запуске (BotHandler::initialize_bots).
+// Пока в потоке действует BacktestResources::Scope, конструктор TradeBot берёт их отсюда, а не из БД.
+struct BacktestResources {
+    std::shared_ptr<Informer> informer;
+    std::shared_ptr<Broker> broker;
+
+    static const BacktestResources*& current() {
+        thread_local const BacktestResources* resources = nullptr;
+        return resources;
+    }
+
+    class Scope {
+    public:
+        explicit Scope(const BacktestResources& resources) : previous_(current()) {
+            current() = &resources;
+        }
+        ~Scope() { current() = previous_; }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const BacktestResources* previous_;
+    };
+};
+
+// Деньги и количество символа бота: сохраняются перед шагом и возвращаются, если сделку не удалось записать
+struct BotBalance {
+    int money;
+    double symbol_count;
+};
+
+// Абстрактный класс TradeBot
 class TradeBot {
 protected:
     std::atomic<bool> is_running;
     std::shared_ptr<Informer> informer;
-    std::shared_ptr<sql::Connection> con;
     std::string symbol;
     int user_id;
     int money;
@@ -36,14 +77,18 @@ protected:
     std::string last_operation = "SELL";
     std::shared_ptr<IndicatorsCalc> indicator;
     std::shared_ptr<Broker> broker;
-    std::map<std::string, std::string> params; //    
+    std::map<std::string, std::string> params; // Храним параметры как копию
     std::string position = "sell";
     std::string start_date = "";
     std::string end_date = get_current_timestamp();
     std::condition_variable cv_;
     std::mutex cv_mutex_;
+    ShardedHistogram* strategy_latency_; // время strategy() в торговом цикле, ряд по strategy_id
+    ParamBlock param_block_;             // собственный блок параметров стратегии (StrategySpec)
+    std::string historical_start_date_;  // период бэктеста из параметров; end_date сдвигается по ходу расчёта
+    std::string historical_end_date_;
 
-    //      
+    // Метод для установления соединения с БД
     std::chrono::seconds get_sleep_duration(const std::string& interval) {
         if (interval == "d") return std::chrono::hours(24);
         if (interval == "15") return std::chrono::minutes(15);
@@ -64,213 +109,333 @@ protected:
  
 
 
+    // Информер по типу рынка брокера из общего кэша брокеров
     void initialize_informer_from_db() {
-        if (!con) {
-            std::cerr << ":    \n";
-            return;
+        BrokerMetadata metadata;
+        if (BrokerMetadataCache::getInstance().find(broker_id, metadata)) {
+            informer = make_informer(metadata.market_type_name);
+        }
+        else {
+            log_error().bot(bot_id) << "Ошибка: брокер " << broker_id << " или его тип рынка не найден";
         }
+    }
+    // Общий цикл бэктеста: применяет стратегию к каждой свече и сообщает о сделках.
+    // on_candle(index, side, price, real_price, quantity), side: 1 - покупка, -1 - продажа, 0 - нет сделки
+    template <typename OnCandle>
+    void run_historical(const CandleSeries& candles, OnCandle&& on_candle) {
+        run_historical(candles, 0, candles.size(), std::forward<OnCandle>(on_candle));
+    }
 
-        try {
-            std::unique_ptr<sql::PreparedStatement> pstmt(con->prepareStatement(
-                "SELECT markettypes.market_type_name "
-                "FROM brokers "
-                "INNER JOIN markets ON markets.id = brokers.market_id "
-                "INNER JOIN markettypes ON markets.market_type_id = markettypes.id "
-                "WHERE brokers.id = ?"
-            ));
-            pstmt->setInt(1, broker_id);
-            std::unique_ptr<sql::ResultSet> res(pstmt->executeQuery());
-
-            if (res->next()) {
-                std::string market_type_name = res->getString("market_type_name");
-                if (market_type_name == "Crypto") {
-                    informer = std::make_shared<ByBitInformer>();
+    // То же на свечах с номерами [first, last): окна одного общего ряда считаются без копирования свечей
+    template <typename OnCandle>
+    void run_historical(const CandleSeries& candles, size_t first, size_t last, OnCandle&& on_candle) {
+        double quantity = 0;
+        double real_price = 0;
+        Span<const int64_t> timestamps = candles.timestamps();
+        Span<const double> closes = candles.close();
+        if (first < last) {
+            // Индикаторы стратегии посчитаются векторно сразу на весь период
+            indicator->begin_backtest(timestamps[first] / 1000, timestamps[last - 1] / 1000);
+        }
+        struct BacktestGuard {
+            IndicatorsCalc& indicator;
+            ~BacktestGuard() { indicator.end_backtest(); }
+        } guard{ *indicator };
+        // Обрабатываем каждую свечу
+        for (size_t i = first; i < last; ++i) {
+            double price = closes[i]; // Используем цену закрытия для стратегии
+            int side = 0;
+
+            end_date = std::to_string(timestamps[i] / 1000);
+            // Применяем стратегию
+            int res = strategy(price);
+            // Логика для покупки/продажи
+            if (res == 1) {
+                quantity = money / price;
+                if (quantity != 0) {
+                    real_price = broker->calculateRealPriceBuy(price, quantity);
+                    quantity = money / real_price;
+                    position = "buy";
+                    count_of_symbol += quantity;
+                    money = 0;
+                    side = 1;
                 }
-                else {
-
-                    if (market_type_name == "Stocks") {
-                        informer = std::make_shared<TinkoffInformer>(Constants::tinkoff_token);
-                    }
-                    else {
-
-                        if (market_type_name == "Forex") {
-                            informer = std::make_shared<YahooForexInformer>();
-                        }
-                        else {
-                            informer = std::make_shared<ByBitInformer>();
-
-                        }
-                    }
-                } 
             }
-        }
-        catch (sql::SQLException& e) {
-            std::cerr << " SQL: " << e.what() << "\n";
+            if (res == -1) {
+                quantity = count_of_symbol;
+                if (quantity != 0) {
+                    real_price = broker->calculateRealPriceSell(price, quantity);
+                    position = "sell";
+                    count_of_symbol = 0;
+                    money = quantity * price;
+                    side = -1;
+                }
+            }
+            on_candle(i, side, price, real_price, quantity);
         }
     }
 public:
+    // Информер рынка по названию типа рынка из markettypes; неизвестный тип - крипторынок
+    static std::shared_ptr<Informer> make_informer(const std::string& market_type_name) {
+        if (market_type_name == "Stocks") {
+            return std::make_shared<TinkoffInformer>(Constants::tinkoff_token);
+        }
+        if (market_type_name == "Forex") {
+            return std::make_shared<YahooForexInformer>();
+        }
+        return std::make_shared<ByBitInformer>();
+    }
+
+    // Параметры проверены по схеме стратегии (StrategyFactory); общие поля уже в нужных типах
     TradeBot(
         int user_id,
         int bot_id,
         int strategy_id,
         int broker_id,
-        const std::map<std::string, std::string>& params
+        const StrategyParams& params
     ) :
+        is_running(false),
+        symbol(params.bot().symbol),
         user_id(user_id),
         bot_id(bot_id),
         strategy_id(strategy_id),
         broker_id(broker_id),
-        symbol(params.at("symbol")),
-        params(params),
-        is_running(false) {
-        con = Constants::createConnection();
-        initialize_informer_from_db();
+        params(params.raw()),
+        param_block_(params.block()) {
+        if (const BacktestResources* shared = BacktestResources::current()) {
+            // Бот для бэктеста внутри перебора параметров: информер и брокер общие, БД не нужна
+            informer = shared->informer;
+            broker = shared->broker;
+        }
+        else {
+            initialize_informer_from_db();
+            broker = std::make_shared<Broker>(broker_id);
+        }
         indicator = std::make_shared<IndicatorsCalc>(this->informer);
-        broker = std::make_shared<Broker>(broker_id);
-        //  ma_length  interval,     
-        money = (params.find("money") != params.end()) ? std::stoi(params.at("money")) :  0;
-        interval = (params.find("interval") != params.end()) ? params.at("interval") : "d";
-
-        count_of_symbol = (params.find("symbol_count") != params.end()) ? std::stoi(params.at("symbol_count")) : 0;
+        strategy_latency_ = &Metrics::getInstance().histogram("tradesnake_strategy_evaluation_duration_seconds",
+            "Strategy evaluation time in the live trading loop by strategy id", { {"strategy_id", std::to_string(strategy_id)} });
+        // Целые части, как раньше давал std::stoi
+        money = static_cast<int>(params.bot().money);
+        interval = params.bot().interval;
+        count_of_symbol = std::trunc(params.bot().symbol_count);
+        historical_start_date_ = params.bot().start_date;
+        historical_end_date_ = params.bot().end_date;
+    }
 
+    // Для стратегий с конструктором от словаря: проверяются только общие параметры
+    TradeBot(
+        int user_id,
+        int bot_id,
+        int strategy_id,
+        int broker_id,
+        const std::map<std::string, std::string>& params
+    ) : TradeBot(user_id, bot_id, strategy_id, broker_id, StrategySpec().validate(params)) {
     }
-    void start() {
-        if (!con) return;
 
+    // Переводит бота в рабочее состояние; false, если информер не удалось определить по БД
+    bool activate() {
+        if (!informer) return false;
         is_running.store(true);
+        return true;
+    }
+
+    // Решение стратегии по текущей цене без записи в БД: позиция бота меняется сразу, а запись возвращается в order.
+    // false - писать нечего; order.type_id == 0 - сделки нет, order.real_price - цена для broker->hold
+    bool evaluate(double current_price, TradeOrder& order) {
         double quantity = 0;
         double real_price;
-        while (is_running.load()) {
-            double current_price = informer->get_symbol_now(symbol);
-            int res = strategy(current_price);
-            if (res == 1) {
-                quantity = money / current_price;
-                if (quantity != 0) {
-                real_price = broker->calculateRealPriceBuy(current_price, quantity);
-                quantity = money / real_price;
-                    broker->buy(bot_id, current_price,real_price, quantity);
-                    count_of_symbol += quantity;
-                    money = 0;
-                }
-            }
-            else {
-                if (res == -1) {
-                    quantity = count_of_symbol;
-                    if (quantity != 0) {
-                    real_price = broker->calculateRealPriceSell(current_price, quantity);
-                        broker->sell(bot_id, current_price, real_price, quantity);
-                        count_of_symbol = 0;
-                        money = quantity * current_price;
-                    }
-                }
-                else {
-                    quantity = 1;
-                    real_price = broker->calculateRealPriceSell(current_price,quantity);
-                    broker->hold(bot_id, real_price);
-                }
-            }
+        // Индикаторы досчитываются до текущего момента по новым свечам
+        end_date = get_current_timestamp();
+        auto evaluation_started = std::chrono::steady_clock::now();
+        int res = strategy(current_price);
+        strategy_latency_->record_since(evaluation_started);
+        if (res == 1) {
+            quantity = money / current_price;
+            if (quantity == 0) return false;
+            real_price = broker->calculateRealPriceBuy(current_price, quantity);
+            quantity = money / real_price;
+            order = { 1, current_price, real_price, quantity };
+            count_of_symbol += quantity;
+            money = 0;
+            return true;
+        }
+        if (res == -1) {
+            quantity = count_of_symbol;
+            if (quantity == 0) return false;
+            real_price = broker->calculateRealPriceSell(current_price, quantity);
+            order = { 2, current_price, real_price, quantity };
+            count_of_symbol = 0;
+            money = quantity * current_price;
+            return true;
+        }
+        quantity = 1;
+        order = { 0, current_price, broker->calculateRealPriceSell(current_price, quantity), quantity };
+        return true;
+    }
 
+    // Один шаг торгового цикла по уже полученной текущей цене
+    virtual void tick(double current_price) {
+        if (!is_running.load()) return;
 
+        // Баланс в памяти меняется только вместе с записью сделки в БД
+        BotBalance saved = save_balance();
+        TradeOrder order;
+        if (!evaluate(current_price, order)) return;
+        bool committed = true;
+        try {
+            if (order.type_id == 1) committed = broker->buy(bot_id, order.current_price, order.real_price, order.quantity);
+            else if (order.type_id == 2) committed = broker->sell(bot_id, order.current_price, order.real_price, order.quantity);
+            else broker->hold(bot_id, order.real_price);
+        }
+        catch (...) {
+            restore_balance(saved);
+            throw;
+        }
+        if (!committed) {
+            restore_balance(saved);
+            log_error() << "Bot " << bot_id << " trade was not written, balance restored.";
+        }
+    }
+
+    virtual void tick() {
+        tick(QuoteService::getInstance().get_symbol_now(informer, symbol));
+    }
+
+    // false - бот торгует несколькими символами и сам получает их цены (PortfolioBot), общая цена группы ему не нужна
+    virtual bool single_symbol() const { return true; }
+
+    // Блокирующий цикл в текущем потоке; BotHandler вместо него использует BotScheduler
+    void start() {
+        if (!activate()) return;
+
+        while (is_running.load()) {
+            tick();
 
             std::unique_lock<std::mutex> lock(cv_mutex_);
-            cv_.wait_for(lock, get_sleep_duration(interval), [this]() {
+            auto wake_at = std::chrono::steady_clock::now() + get_sleep_duration(interval);
+            cv_.wait_until(lock, wake_at, [this]() {
                 return !is_running.load();
                 });
 
             if (!is_running.load()) {
                 break;
             }
+            Metrics::scheduler_lag().record_since(wake_at);
         }
     }
-    //       
-    std::vector<HistoricalResult> execute_historical() {
-        std::vector<HistoricalResult> results;
+
+    bool running() const { return is_running.load(); }
+    int get_bot_id() const { return bot_id; }
+    int get_strategy_id() const { return strategy_id; }
+    const std::string& get_symbol() const { return symbol; }
+    const std::string& get_interval() const { return interval; }
+    int get_money() const { return money; }
+    double get_symbol_count() const { return count_of_symbol; }
+    BotBalance save_balance() const { return { money, count_of_symbol }; }
+    void restore_balance(const BotBalance& saved) {
+        money = saved.money;
+        count_of_symbol = saved.symbol_count;
+    }
+
+    // Метод для выполнения стратегии на исторических данных
+    HistoricalResult execute_historical() {
         auto start_time = std::chrono::high_resolution_clock::now();
 
-        //       
-         start_date = (params.find("start_date") != params.end()) ? params.at("start_date") : "0";
-         end_date = (params.find("end_date") != params.end()) ? params.at("end_date") : "0";
+        HistoricalResult result = execute_historical(std::make_shared<const CandleSeries>(load_historical_candles()));
+
+        // Запоминаем время окончания выполнения метода
+        auto end_time = std::chrono::high_resolution_clock::now();
+
+        // Вычисляем продолжительность выполнения
+        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+
+        // Выводим время выполнения в консоль
+        log_info() << "Execution time of execute_historical: " << duration << " milliseconds";
 
-         double quantity = 0;
-         double real_price;
-        //   
-        std::vector<CandleData> candles = informer->get_symbol_historical(symbol, start_date, end_date, interval);
-        std::sort(candles.begin(), candles.end(), [](const CandleData& a, const CandleData& b) {
-            return a.timestamp < b.timestamp;
+        return result;
+    }
+
+    // Бэктест на заранее загруженных и отсортированных свечах: свечи не копируются, сохраняются только сделки
+    HistoricalResult execute_historical(std::shared_ptr<const CandleSeries> candles) {
+        HistoricalResult result{ candles, {} };
+        execute_historical(*candles, [&result](size_t, const TradeEvent* trade) {
+            if (trade) result.trades.push_back(*trade);
             });
+        return result;
+    }
 
-        int broker_price;
-        //   
-        for (size_t i = 0; i < candles.size(); ++i) {
-
-            const auto& candle = candles[i];
-            double price = candle.close; //     
-
-            //     
-            HistoricalResult result = {
-                candle.timestamp,
-                candle.open,
-                candle.close,
-                candle.high,
-                candle.low,
-                candle.volume,
-                candle.turnover,
-                {},  
-                {}
-            };
-            end_date = candle.timestamp;
-            if (end_date.size() >= 3) {
-                end_date.erase(end_date.size() - 3);
+    // Бэктест с выдачей по одной свече по мере расчёта, без накопления всего ответа:
+    // on_candle(index, trade), trade - nullptr на свечах без сделки
+    template <typename OnCandle>
+    void execute_historical(const CandleSeries& candles, OnCandle&& on_candle) {
+        run_historical(candles, [&on_candle](size_t i, int side, double price, double real_price, double quantity) {
+            if (side == 0) {
+                on_candle(i, static_cast<const TradeEvent*>(nullptr));
+                return;
             }
-            //  
-            int res = strategy(price);
-            //   /
-            if (res == 1) {
-                quantity = money / price;
-                if (!quantity == 0) {
-                    real_price = broker->calculateRealPriceBuy(price, quantity);
-                    quantity = money / real_price;
-                    result.buy = { {"price", price * quantity},{"broker_price", real_price * quantity}, {"quantity", quantity} }; //  
-                    position = "buy";
-                    count_of_symbol += quantity;
-                    money = 0;
-                }
+            TradeEvent trade{ static_cast<uint32_t>(i), side, price * quantity, real_price * quantity, quantity };
+            on_candle(i, &trade);
+            });
+    }
 
+    // Бэктест без покандельного результата: только итоговые метрики
+    BacktestSummary execute_historical_summary(const CandleSeries& candles) {
+        return execute_historical_summary(candles, 0, candles.size());
+    }
+
+    // Итоговые метрики на свечах с номерами [first, last) общего ряда
+    BacktestSummary execute_historical_summary(const CandleSeries& candles, size_t first, size_t last) {
+        BacktestSummary summary{};
+        Span<const double> closes = candles.close();
+        summary.initial_money = money + count_of_symbol * (first < last ? closes[first] : 0.0);
+        double peak = summary.initial_money;
+        double equity = summary.initial_money;
+        double entry_cost = 0.0;
+
+        run_historical(candles, first, last, [&](size_t i, int side, double price, double real_price, double quantity) {
+            if (side == 1) {
+                ++summary.trades;
+                entry_cost = real_price * quantity;
             }
-            if (res == -1) {
-                quantity = count_of_symbol;
-                if (!quantity == 0) {
-                real_price = broker->calculateRealPriceSell(price, quantity);
-                    result.sell = { {"price", price * quantity},
-                        {"broker_price", real_price * quantity},
-                        { "quantity",quantity } }; //  
-                    position = "sell";                    count_of_symbol = 0;
-                    money = quantity * price;
-                }
+            if (side == -1) {
+                ++summary.trades;
+                if (real_price * quantity > entry_cost) ++summary.winning_trades;
             }
- 
-
-            results.push_back(result);
-
-        }
-        //     
-        auto end_time = std::chrono::high_resolution_clock::now();
+            equity = money + count_of_symbol * closes[i];
+            peak = std::max(peak, equity);
+            if (peak > 0) {
+                summary.max_drawdown = std::max(summary.max_drawdown, (peak - equity) / peak * 100.0);
+            }
+            });
 
-        //   
-        auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
+        summary.final_equity = equity;
+        summary.pnl = equity - summary.initial_money;
+        summary.return_percent = summary.initial_money != 0 ? summary.pnl / summary.initial_money * 100.0 : 0.0;
+        return summary;
+    }
 
-        //     
-        std::cout << "Execution time of execute_historical: " << duration << " milliseconds\n";
+    // Свечи периода бэктеста из параметров start_date / end_date
+    CandleSeries load_historical_candles() {
+        start_date = historical_start_date_;
+        end_date = historical_end_date_;
 
-        return results;
+        // Получаем исторические данные (кэш отдаёт их уже упорядоченными по времени)
+        return CandleCache::getInstance().get_symbol_historical(informer, symbol, start_date, end_date, interval);
     }
-    
+
+    std::shared_ptr<Informer> get_informer() const { return informer; }
+    std::shared_ptr<Broker> get_broker() const { return broker; }
 
     void stop() {
         is_running.store(false);
         cv_.notify_all();
     } 
-    //1: -1 0   
+    // Поля блока параметров, зарегистрированного для стратегии в strategy_registrations.hpp;
+    // читаются один раз в конструкторе стратегии, а не в strategy()
+    template <typename Block>
+    const Block& strategy_params() const { return param_block_.get<Block>(); }
+
+    //1:купить -1продать 0 ничего не делать
     virtual int strategy(double price) = 0;
 
     
@@ -0,0 +1,98 @@
+#ifndef LATENCY_HISTOGRAM_HPP
+#define LATENCY_HISTOGRAM_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Снимок гистограммы задержек (все времена в микросекундах)
+struct LatencySnapshot {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t p50_us;
+    uint64_t p90_us;
+    uint64_t p99_us;
+};
+
+// Гистограмма задержек с фиксированными корзинами 1-2-5 от 1 мкс до 10 с; запись без блокировок
+class LatencyHistogram {
+public:
+    static constexpr size_t bucket_count = 23;
+
+    // Верхние границы корзин; последняя корзина (+Inf) хранит всё, что больше
+    static const std::array<uint64_t, bucket_count>& bounds_us() {
+        static const std::array<uint64_t, bucket_count> bounds = {
+            1, 2, 5,
+            10, 20, 50,
+            100, 200, 500,
+            1000, 2000, 5000,
+            10000, 20000, 50000,
+            100000, 200000, 500000,
+            1000000, 2000000, 5000000,
+            10000000, UINT64_MAX
+        };
+        return bounds;
+    }
+
+    void record(std::chrono::microseconds duration) {
+        uint64_t us = duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0;
+        const auto& bounds = bounds_us();
+        size_t index = 0;
+        while (us > bounds[index]) ++index;
+        buckets_[index].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(us, std::memory_order_relaxed);
+
+        uint64_t max = max_us_.load(std::memory_order_relaxed);
+        while (us > max && !max_us_.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t bucket(size_t index) const { return buckets_[index].load(std::memory_order_relaxed); }
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum_us() const { return sum_us_.load(std::memory_order_relaxed); }
+
+    // Квантили оцениваются по верхней границе корзины (не больше наблюдавшегося максимума)
+    LatencySnapshot snapshot() const {
+        LatencySnapshot result{};
+        result.count = count();
+        result.sum_us = sum_us();
+        result.max_us = max_us_.load(std::memory_order_relaxed);
+        result.p50_us = quantile(0.50, result.max_us);
+        result.p90_us = quantile(0.90, result.max_us);
+        result.p99_us = quantile(0.99, result.max_us);
+        return result;
+    }
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> buckets_{};
+    std::atomic<uint64_t> count_{ 0 };
+    std::atomic<uint64_t> sum_us_{ 0 };
+    std::atomic<uint64_t> max_us_{ 0 };
+
+    uint64_t quantile(double q, uint64_t max) const {
+        uint64_t total = 0;
+        std::array<uint64_t, bucket_count> counts;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            counts[i] = bucket(i);
+            total += counts[i];
+        }
+        if (total == 0) return 0;
+
+        uint64_t rank = static_cast<uint64_t>(q * total + 0.5);
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return bounds_us()[i] < max ? bounds_us()[i] : max;
+            }
+        }
+        return max;
+    }
+};
+
+#endif // LATENCY_HISTOGRAM_HPP
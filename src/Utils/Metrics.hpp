@@ -0,0 +1,267 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include "./LatencyHistogram.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+// Номер ячейки потока: потоки раскладываются по ячейкам по кругу и пишут каждый в свою
+inline size_t metrics_shard_index() {
+    static constexpr size_t shard_count = 16;
+    static std::atomic<size_t> next{ 0 };
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % shard_count;
+    return index;
+}
+
+// Счётчик по ячейкам потоков; сумма считается только при чтении
+class ShardedCounter {
+public:
+    void add(uint64_t value = 1) {
+        shards_[metrics_shard_index()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const {
+        uint64_t total = 0;
+        for (const auto& shard : shards_) total += shard.value.load(std::memory_order_relaxed);
+        return total;
+    }
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{ 0 };
+    };
+    std::array<Shard, 16> shards_;
+};
+
+// Гистограмма задержек по ячейкам потоков (корзины LatencyHistogram); ячейки суммируются при чтении
+class ShardedHistogram {
+public:
+    void record(std::chrono::microseconds duration) {
+        shards_[metrics_shard_index()].histogram.record(duration);
+    }
+
+    template <typename Duration>
+    void record_since(std::chrono::time_point<std::chrono::steady_clock, Duration> started) {
+        record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started));
+    }
+
+    // Число значений в каждой корзине и сумма в микросекундах
+    std::array<uint64_t, LatencyHistogram::bucket_count> buckets(uint64_t& sum_us) const {
+        std::array<uint64_t, LatencyHistogram::bucket_count> result{};
+        sum_us = 0;
+        for (const auto& shard : shards_) {
+            for (size_t i = 0; i < LatencyHistogram::bucket_count; ++i) result[i] += shard.histogram.bucket(i);
+            sum_us += shard.histogram.sum_us();
+        }
+        return result;
+    }
+
+private:
+    struct alignas(64) Shard {
+        LatencyHistogram histogram;
+    };
+    std::array<Shard, 16> shards_;
+};
+
+// Записывает время жизни объекта в гистограмму
+class ScopedTimer {
+public:
+    explicit ScopedTimer(ShardedHistogram& histogram)
+        : histogram_(histogram), started_(std::chrono::steady_clock::now()) {
+    }
+    ~ScopedTimer() { histogram_.record_since(started_); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    ShardedHistogram& histogram_;
+    std::chrono::steady_clock::time_point started_;
+};
+
+// Реестр метрик процесса для GET /metrics (текстовый формат Prometheus).
+// Ряды создаются при первом обращении и живут до конца процесса, поэтому ссылку на ряд можно запомнить
+// и дальше писать в него без поиска и блокировок. Значения, которые и так считают другие компоненты
+// (статистика кэшей, число ботов), подключаются функциями, вызываемыми при чтении.
+class Metrics {
+public:
+    static Metrics& getInstance() {
+        static Metrics instance;
+        return instance;
+    }
+
+    ShardedCounter& counter(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+        return series(counters_, name, help, labels);
+    }
+
+    ShardedHistogram& histogram(const std::string& name, const std::string& help, const MetricLabels& labels = {}) {
+        return series(histograms_, name, help, labels);
+    }
+
+    // type - "gauge" или "counter"; value вызывается при каждом чтении /metrics
+    void callback(const std::string& name, const std::string& help, const std::string& type,
+        const MetricLabels& labels, std::function<double()> value) {
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        Family<std::function<double()>>& family = callbacks_[name];
+        family.help = help;
+        family.type = type;
+        family.series[render_labels(labels)] = std::make_unique<std::function<double()>>(std::move(value));
+    }
+
+    // Все ряды в текстовом формате Prometheus; задержки - в секундах
+    std::string render() const {
+        std::string out;
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        for (const auto& family : counters_) {
+            write_header(out, family.first, family.second.help, "counter");
+            for (const auto& item : family.second.series) {
+                write_sample(out, family.first, item.first, static_cast<double>(item.second->value()));
+            }
+        }
+        for (const auto& family : callbacks_) {
+            write_header(out, family.first, family.second.help, family.second.type);
+            for (const auto& item : family.second.series) {
+                write_sample(out, family.first, item.first, (*item.second)());
+            }
+        }
+        for (const auto& family : histograms_) {
+            write_header(out, family.first, family.second.help, "histogram");
+            for (const auto& item : family.second.series) {
+                uint64_t sum_us = 0;
+                auto buckets = item.second->buckets(sum_us);
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < LatencyHistogram::bucket_count; ++i) {
+                    cumulative += buckets[i];
+                    uint64_t bound = LatencyHistogram::bounds_us()[i];
+                    std::string le = bound == UINT64_MAX ? "+Inf" : format_number(static_cast<double>(bound) / 1e6);
+                    write_sample(out, family.first + "_bucket", join_labels(item.first, "le=\"" + le + "\""),
+                        static_cast<double>(cumulative));
+                }
+                write_sample(out, family.first + "_sum", item.first, static_cast<double>(sum_us) / 1e6);
+                write_sample(out, family.first + "_count", item.first, static_cast<double>(cumulative));
+            }
+        }
+        return out;
+    }
+
+    // Ряды, в которые пишут несколько компонентов
+    static ShardedHistogram& informer_latency(const std::type_info& informer, const std::string& method) {
+        return getInstance().histogram("tradesnake_informer_request_duration_seconds",
+            "Informer request latency by informer type and method",
+            { {"informer", type_label(informer)}, {"method", method} });
+    }
+
+    static ShardedHistogram& sql_latency(const std::string& statement) {
+        return getInstance().histogram("tradesnake_sql_statement_duration_seconds",
+            "MySQL statement latency by statement", { {"statement", statement} });
+    }
+
+    static ShardedHistogram& scheduler_lag() {
+        return getInstance().histogram("tradesnake_scheduler_lag_seconds",
+            "Delay between the intended and the actual wake-up of a bot step");
+    }
+
+    // Читаемое имя типа для меток: без "class " (MSVC) и длины имени (GCC/Clang)
+    static std::string type_label(const std::type_info& type) {
+        std::string name = type.name();
+        for (const char* prefix : { "class ", "struct " }) {
+            if (name.compare(0, std::char_traits<char>::length(prefix), prefix) == 0) {
+                return name.substr(std::char_traits<char>::length(prefix));
+            }
+        }
+        size_t digits = 0;
+        while (digits < name.size() && name[digits] >= '0' && name[digits] <= '9') ++digits;
+        return name.substr(digits);
+    }
+
+private:
+    template <typename T>
+    struct Family {
+        std::string help;
+        std::string type;
+        std::map<std::string, std::unique_ptr<T>> series; // ключ - метки в виде name="value",...
+    };
+
+    mutable std::shared_mutex mutex_;
+    std::map<std::string, Family<ShardedCounter>> counters_;
+    std::map<std::string, Family<ShardedHistogram>> histograms_;
+    std::map<std::string, Family<std::function<double()>>> callbacks_;
+
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+
+    template <typename T>
+    T& series(std::map<std::string, Family<T>>& families, const std::string& name, const std::string& help,
+        const MetricLabels& labels) {
+        std::string key = render_labels(labels);
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto family = families.find(name);
+            if (family != families.end()) {
+                auto it = family->second.series.find(key);
+                if (it != family->second.series.end()) return *it->second;
+            }
+        }
+        std::unique_lock<std::shared_mutex> lock(mutex_);
+        Family<T>& family = families[name];
+        family.help = help;
+        auto& value = family.series[key];
+        if (!value) value = std::make_unique<T>();
+        return *value;
+    }
+
+    static std::string render_labels(const MetricLabels& labels) {
+        std::string out;
+        for (const auto& label : labels) {
+            if (!out.empty()) out += ",";
+            out += label.first + "=\"";
+            for (char c : label.second) {
+                if (c == '\\' || c == '"') out += '\\';
+                if (c == '\n') {
+                    out += "\\n";
+                    continue;
+                }
+                out += c;
+            }
+            out += "\"";
+        }
+        return out;
+    }
+
+    static std::string join_labels(const std::string& labels, const std::string& extra) {
+        return labels.empty() ? extra : labels + "," + extra;
+    }
+
+    static std::string format_number(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.15g", value);
+        return buffer;
+    }
+
+    static void write_header(std::string& out, const std::string& name, const std::string& help, const std::string& type) {
+        out += "# HELP " + name + " " + help + "\n";
+        out += "# TYPE " + name + " " + type + "\n";
+    }
+
+    static void write_sample(std::string& out, const std::string& name, const std::string& labels, double value) {
+        out += name;
+        if (!labels.empty()) out += "{" + labels + "}";
+        out += " " + format_number(value) + "\n";
+    }
+};
+
+#endif // METRICS_HPP
@@ -0,0 +1,36 @@
+#ifndef SPAN_HPP
+#define SPAN_HPP
+
+#include <algorithm>
+#include <cstddef>
+
+// Невладеющее окно над непрерывным массивом (аналог std::span из C++20)
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_(data), size_(size) {
+    }
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    T& operator[](size_t index) const { return data_[index]; }
+    T& front() const { return data_[0]; }
+    T& back() const { return data_[size_ - 1]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+
+    // Подокно [offset, offset + count), обрезанное по размеру
+    Span subspan(size_t offset, size_t count = static_cast<size_t>(-1)) const {
+        offset = std::min(offset, size_);
+        return Span(data_ + offset, std::min(count, size_ - offset));
+    }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // SPAN_HPP
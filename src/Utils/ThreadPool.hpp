@@ -0,0 +1,178 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Пул потоков с перехватом задач: у каждого потока своя очередь,
+// свободный поток забирает работу из чужих очередей
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threads = std::thread::hardware_concurrency()) {
+        threads = std::max(1u, threads);
+        queues_.reserve(threads);
+        for (unsigned int i = 0; i < threads; ++i) {
+            queues_.push_back(std::make_unique<WorkQueue>());
+        }
+        workers_.reserve(threads);
+        for (unsigned int i = 0; i < threads; ++i) {
+            workers_.emplace_back([this, i]() { worker_loop(i); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Общий пул процесса для вычислительных задач
+    static ThreadPool& shared() {
+        static ThreadPool instance;
+        return instance;
+    }
+
+    size_t size() const { return workers_.size(); }
+
+    template <typename F>
+    auto submit(F&& task) -> std::future<typename std::invoke_result<F>::type> {
+        using Result = typename std::invoke_result<F>::type;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        push([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // Выполняет body(i) для i в [0, count) и ждёт завершения всех итераций
+    template <typename F>
+    void parallel_for(size_t count, F&& body) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            futures.push_back(submit([&body, i]() { body(i); }));
+        }
+        for (auto& future : futures) {
+            // Ожидающий поток сам выполняет задачи, чтобы вложенные вызовы не блокировали пул
+            while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                if (!run_pending_task()) {
+                    future.wait_for(std::chrono::microseconds(100));
+                }
+            }
+            future.get();
+        }
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> next_queue_{ 0 };
+    std::atomic<size_t> pending_{ 0 };
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+
+    // Индекс очереди текущего потока (-1 для потоков вне пула)
+    static int& local_index() {
+        thread_local int index = -1;
+        return index;
+    }
+
+    static ThreadPool*& local_pool() {
+        thread_local ThreadPool* pool = nullptr;
+        return pool;
+    }
+
+    void push(std::function<void()> task) {
+        // Задачи, порождённые внутри пула, кладём в свою очередь, остальные - по кругу
+        size_t index = (local_pool() == this && local_index() >= 0)
+            ? static_cast<size_t>(local_index())
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        {
+            std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+            queues_[index]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+            pending_.fetch_add(1, std::memory_order_release);
+        }
+        wake_.notify_one();
+    }
+
+    bool pop_local(size_t index, std::function<void()>& task) {
+        WorkQueue& queue = *queues_[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, std::function<void()>& task) {
+        for (size_t offset = 1; offset < queues_.size(); ++offset) {
+            WorkQueue& queue = *queues_[(thief + offset) % queues_.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool run_pending_task() {
+        size_t index = (local_pool() == this && local_index() >= 0) ? static_cast<size_t>(local_index()) : 0;
+        std::function<void()> task;
+        if (pop_local(index, task) || steal(index, task)) {
+            pending_.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            return true;
+        }
+        return false;
+    }
+
+    void worker_loop(size_t index) {
+        local_index() = static_cast<int>(index);
+        local_pool() = this;
+        while (true) {
+            std::function<void()> task;
+            if (pop_local(index, task) || steal(index, task)) {
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_.wait(lock, [this]() {
+                return stopping_ || pending_.load(std::memory_order_acquire) > 0;
+                });
+            if (stopping_ && pending_.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,34 @@
+#ifndef TIME_UTILS_HPP
+#define TIME_UTILS_HPP
+
+#include <chrono>
+#include <string>
+
+namespace TimeUtils {
+
+    // Длительность интервала свечи в секундах (0 для неподдерживаемых интервалов)
+    inline long long interval_seconds(const std::string& interval) {
+        if (interval == "1") return 60;
+        if (interval == "5") return 5 * 60;
+        if (interval == "15") return 15 * 60;
+        if (interval == "30") return 30 * 60;
+        if (interval == "60") return 60 * 60;
+        if (interval == "d") return 24 * 60 * 60;
+        return 0;
+    }
+
+    // Текущее время в секундах от начала эпохи
+    inline long long now_seconds() {
+        return std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Начало интервала, в который попадает момент времени
+    inline long long align_down(long long seconds, long long step) {
+        if (step <= 0) return seconds;
+        long long aligned = seconds - seconds % step;
+        return (seconds < 0 && seconds % step != 0) ? aligned - step : aligned;
+    }
+}
+
+#endif // TIME_UTILS_HPP
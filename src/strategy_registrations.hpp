@@ -3,25 +3,32 @@
 #include "./TradeBots/Crypto/RSITradeBot.hpp"   
 #include "./TradeBots/Crypto/MARSITradeBot.hpp"   
 #include "./TradeBots/Crypto/NewsStrategy.hpp"   
+#include "./TradeBots/PortfolioBot.hpp"
 
-//  
+// Регистрация стратегий. Третий аргумент registerStrategy - схема параметров (StrategySpec): без неё
+// проверяются только общие параметры бота, со своим блоком стратегия получает его поля уже в нужных типах
 inline void registerStrategies() {
-    //   MA
-    StrategyFactory::getInstance().registerStrategy(1, []( int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>& params) {
+    // Регистрация стратегии MA
+    StrategyFactory::getInstance().registerStrategy(1, []( int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams& params) {
         return std::make_unique<MA_strategy>(user_id, bot_id, strategy_id, broker_id, params);
         });
 
-    //   ConcretteTradeBot
-    StrategyFactory::getInstance().registerStrategy(2, []( int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>& params) {
+    // Регистрация стратегии ConcretteTradeBot
+    StrategyFactory::getInstance().registerStrategy(2, []( int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams& params) {
         return std::make_unique<RSITradeBot>( user_id, bot_id, strategy_id, broker_id, params);
         });
-    //   MARSI
-    StrategyFactory::getInstance().registerStrategy(3, [](int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>& params) {
+    // Регистрация стратегии MARSI
+    StrategyFactory::getInstance().registerStrategy(3, [](int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams& params) {
         return std::make_unique<MA_RSI_Strategy>(user_id, bot_id, strategy_id, broker_id, params);
         });
-    //    
-    StrategyFactory::getInstance().registerStrategy(4, [](int user_id, int bot_id, int strategy_id, int broker_id, const std::map<std::string, std::string>& params) {
+    // Регистрация стратегии с новостями
+    StrategyFactory::getInstance().registerStrategy(4, [](int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams& params) {
         return std::make_unique<NewsStrategy>(user_id, bot_id, strategy_id, broker_id, params);
         });
+
+    // Портфель: любая из стратегий выше на списке символов из параметра symbols
+    StrategyFactory::getInstance().registerPortfolio([](int user_id, int bot_id, int strategy_id, int broker_id, const StrategyParams& params) {
+        return std::make_unique<PortfolioBot>(user_id, bot_id, strategy_id, broker_id, params);
+        });
 }
 
@@ -1,6 +1,10 @@
 #include <iostream>
 #include <map>
+#include <memory>
 #include <optional>
+#include <cstdint>
+#include <string>
+#include <vector>
 #ifndef STRUCT_HPP
 #define STRUCT_HPP
 
@@ -15,18 +19,34 @@ struct HistoricalData {
     double turnover;
 };
 
+// Сделка бэктеста фиксированного размера; суммы - как в ответе /execute_historical (цена * количество)
+struct TradeEvent {
+    uint32_t index;         // номер свечи в серии
+    int32_t side;           // 1 - покупка, -1 - продажа
+    double price;
+    double broker_price;
+    double quantity;
+};
+static_assert(sizeof(TradeEvent) == 32, "TradeEvent must stay 32 bytes");
+
+class CandleSeries;
+
+// Результат бэктеста: ссылка на общие свечи периода и сделки по ним (только на свечах, где они были)
 struct HistoricalResult {
-    std::string timestamp;
-    double open;
-    double close;
-    double high;
-    double low;
-    double volume;
-    double turnover;
-    std::map<std::string, double> buy;   
-    std::map<std::string, double> sell; 
+    std::shared_ptr<const CandleSeries> candles;
+    std::vector<TradeEvent> trades;
 };
 
+// Итоговые метрики бэктеста
+struct BacktestSummary {
+    double initial_money;
+    double final_equity;
+    double pnl;
+    double return_percent;
+    double max_drawdown;    // максимальная просадка, %
+    int trades;
+    int winning_trades;
+};
 
 struct CandleData {
     std::string timestamp;